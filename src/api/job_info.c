@@ -1197,6 +1197,7 @@ static int _load_fed_jobs(slurm_msg_t *req_msg,
 				orig_msg->record_count = new_rec_cnt;
 			}
 			xfree(new_msg->job_array);
+			xfree(new_msg->purged_job_ids);
 			xfree(new_msg);
 		}
 		xfree(job_resp);
@@ -1333,7 +1334,7 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	    cluster_in_federation(ptr, cluster_name)) {
 		/* In federation. Need full info from all clusters */
 		update_time = (time_t) 0;
-		show_flags &= (~SHOW_LOCAL);
+		show_flags &= (~(SHOW_LOCAL | SHOW_DELTA));
 	} else {
 		/* Report local cluster info only */
 		show_flags |= SHOW_LOCAL;
@@ -1362,6 +1363,99 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return rc;
 }
 
+typedef struct {
+	uint32_t job_id;
+	uint32_t inx;
+} job_inx_t;
+
+static int _cmp_job_inx(const void *a, const void *b)
+{
+	uint32_t id_a = ((job_inx_t *) a)->job_id;
+	uint32_t id_b = ((job_inx_t *) b)->job_id;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+/* Return index of job_id in the job array, or -1 if not found */
+static int _find_job_inx(job_inx_t *sorted, uint32_t cnt, uint32_t job_id)
+{
+	job_inx_t key = { .job_id = job_id }, *found;
+
+	if (!(found = bsearch(&key, sorted, cnt, sizeof(job_inx_t),
+			      _cmp_job_inx)))
+		return -1;
+	return found->inx;
+}
+
+extern void slurm_merge_job_info_msg(job_info_msg_t *old_msg,
+				     job_info_msg_t *new_msg)
+{
+	job_inx_t *sorted;
+	uint32_t i, j, new_cnt;
+	bool *removed;
+	int inx;
+
+	xassert(old_msg);
+	xassert(new_msg);
+	xassert(new_msg->delta);
+
+	sorted = xcalloc(old_msg->record_count + 1, sizeof(job_inx_t));
+	removed = xcalloc(old_msg->record_count + 1, sizeof(bool));
+	for (i = 0; i < old_msg->record_count; i++) {
+		sorted[i].job_id = old_msg->job_array[i].job_id;
+		sorted[i].inx = i;
+	}
+	qsort(sorted, old_msg->record_count, sizeof(job_inx_t), _cmp_job_inx);
+
+	for (i = 0; i < new_msg->purged_cnt; i++) {
+		inx = _find_job_inx(sorted, old_msg->record_count,
+				    new_msg->purged_job_ids[i]);
+		if ((inx < 0) || removed[inx])
+			continue;
+		slurm_free_job_info_members(&old_msg->job_array[inx]);
+		removed[inx] = true;
+	}
+
+	/* Replace changed jobs in place, move new jobs to the front */
+	new_cnt = 0;
+	for (i = 0; i < new_msg->record_count; i++) {
+		inx = _find_job_inx(sorted, old_msg->record_count,
+				    new_msg->job_array[i].job_id);
+		if ((inx < 0) || removed[inx]) {
+			if (new_cnt != i)
+				new_msg->job_array[new_cnt] =
+					new_msg->job_array[i];
+			new_cnt++;
+			continue;
+		}
+		slurm_free_job_info_members(&old_msg->job_array[inx]);
+		old_msg->job_array[inx] = new_msg->job_array[i];
+	}
+
+	/* Compact the remaining jobs and append the new ones */
+	for (i = 0, j = 0; i < old_msg->record_count; i++) {
+		if (removed[i])
+			continue;
+		if (i != j)
+			old_msg->job_array[j] = old_msg->job_array[i];
+		j++;
+	}
+	if (new_cnt) {
+		xrecalloc(old_msg->job_array, j + new_cnt,
+			  sizeof(slurm_job_info_t));
+		memcpy(&old_msg->job_array[j], new_msg->job_array,
+		       sizeof(slurm_job_info_t) * new_cnt);
+	}
+	old_msg->record_count = j + new_cnt;
+	old_msg->last_update = new_msg->last_update;
+
+	xfree(removed);
+	xfree(sorted);
+	xfree(new_msg->job_array);
+	xfree(new_msg->purged_job_ids);
+	xfree(new_msg);
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
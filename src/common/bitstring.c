@@ -77,6 +77,36 @@
 #define	_bitstr_words(nbits)	\
 	((((nbits) + BITSTR_MAXPOS) >> BITSTR_SHIFT) + BITSTR_OVERHEAD)
 
+/* number of data words (excluding the header) in a bitstring */
+#define _bitstr_data_words(name) \
+	(_bitstr_words(_bitstr_bits(name)) - BITSTR_OVERHEAD)
+
+/* mask of the valid bits in a trailing partial word holding nbits bits */
+#ifdef SLURM_BIGENDIAN
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)(~(uint64_t)0 << (BITSTR_MAXPOS + 1 - ((nbits) & BITSTR_MAXPOS))))
+#else
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)(((uint64_t)1 << ((nbits) & BITSTR_MAXPOS)) - 1))
+#endif
+
+/*
+ * The word counting kernels below are cloned by the compiler for several
+ * x86_64 feature levels and the dynamic loader picks the best one for the
+ * running CPU, so a generic build still gets hardware popcount (and AVX2 where
+ * the loop vectorizes). Other architectures use their baseline, which already
+ * includes a vector popcount on aarch64 (NEON cnt).
+ */
+#if defined(__x86_64__) && defined(__GLIBC__) && defined(__has_attribute)
+#  if __has_attribute(target_clones)
+#    define BIT_KERNEL_CLONES \
+	__attribute__((target_clones("avx2", "popcnt", "default")))
+#  endif
+#endif
+#ifndef BIT_KERNEL_CLONES
+#  define BIT_KERNEL_CLONES
+#endif
+
 /* check signature */
 #define _assert_bitstr_valid(name) do { \
 	xassert((name) != NULL); \
@@ -464,35 +494,37 @@ bit_nffs(bitstr_t *b, int32_t n)
 bitoff_t
 bit_ffs(bitstr_t *b)
 {
-	bitoff_t bit = 0, value = -1;
+	const bitstr_t *w = b + BITSTR_OVERHEAD;
+	bitoff_t bit_cnt, value;
+	int64_t word = 0, words;
 
 	_assert_bitstr_valid(b);
 
-	while (bit < _bitstr_bits(b) && value == -1) {
-		int32_t word = _bit_word(bit);
+	bit_cnt = _bitstr_bits(b);
+	words = _bitstr_data_words(b);
+
+	/* Skip empty words in blocks of four, like bit_overlap_any() */
+	while (((word + 4) <= words) &&
+	       !(w[word] | w[word + 1] | w[word + 2] | w[word + 3]))
+		word += 4;
+	while ((word < words) && !w[word])
+		word++;
+	if (word >= words)
+		return -1;
 
-		if (b[word] == 0) {
-			bit += sizeof(bitstr_t)*8;
-			continue;
-		}
+	value = word << BITSTR_SHIFT;
 #if HAVE___BUILTIN_CLZLL && (defined SLURM_BIGENDIAN)
-		value = bit + __builtin_clzll(b[word]);
+	value += __builtin_clzll(w[word]);
 #elif HAVE___BUILTIN_CTZLL && (!defined SLURM_BIGENDIAN)
-		value = bit + __builtin_ctzll(b[word]);
+	value += __builtin_ctzll(w[word]);
 #else
-		while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
-			if (bit_test(b, bit)) {
-				value = bit;
-				break;
-			}
-			bit++;
-		}
+	while (!(w[word] & _bit_mask(value)))
+		value++;
 #endif
-	}
-	if (value < _bitstr_bits(b))
-		return value;
-	else
+	/* Only stray bits past the end of a tail word */
+	if (value >= bit_cnt)
 		return -1;
+	return value;
 }
 
 /*
@@ -571,15 +603,16 @@ bit_fill_gaps(bitstr_t *b)
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	const bitstr_t *w1 = b1 + BITSTR_OVERHEAD, *w2 = b2 + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
+	nwords = _bitstr_data_words(b1);
+	for (i = 0; i < nwords; i++) {
+		if (w1[i] & ~w2[i])
 			return 0;
 	}
 
@@ -592,20 +625,14 @@ bit_super_set(bitstr_t *b1, bitstr_t *b2)
 extern int
 bit_equal(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	if (_bitstr_bits(b1) != _bitstr_bits(b2))
 		return 0;
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != b2[_bit_word(bit)])
-			return 0;
-	}
-
-	return 1;
+	return !memcmp(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD,
+		       _bitstr_data_words(b1) * sizeof(bitstr_t));
 }
 
 
@@ -618,14 +645,17 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = b1 + BITSTR_OVERHEAD;
+	const bitstr_t *w2 = b2 + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	nwords = _bitstr_data_words(b1);
+	for (i = 0; i < nwords; i++)
+		w1[i] &= w2[i];
 }
 
 /*
@@ -635,14 +665,17 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = b1 + BITSTR_OVERHEAD;
+	const bitstr_t *w2 = b2 + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+	nwords = _bitstr_data_words(b1);
+	for (i = 0; i < nwords; i++)
+		w1[i] &= ~w2[i];
 }
 
 /*
@@ -652,12 +685,14 @@ void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 void
 bit_not(bitstr_t *b)
 {
-	bitoff_t bit;
+	bitstr_t *w = b + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b);
 
-	for (bit = 0; bit < _bitstr_bits(b); bit += sizeof(bitstr_t)*8)
-		b[_bit_word(bit)] = ~b[_bit_word(bit)];
+	nwords = _bitstr_data_words(b);
+	for (i = 0; i < nwords; i++)
+		w[i] = ~w[i];
 }
 
 /*
@@ -668,14 +703,17 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = b1 + BITSTR_OVERHEAD;
+	const bitstr_t *w2 = b2 + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	nwords = _bitstr_data_words(b1);
+	for (i = 0; i < nwords; i++)
+		w1[i] |= w2[i];
 }
 
 /*
@@ -685,14 +723,17 @@ bit_or(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_or_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = b1 + BITSTR_OVERHEAD;
+	const bitstr_t *w2 = b2 + BITSTR_OVERHEAD;
+	int64_t i, nwords;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= ~b2[_bit_word(bit)];
+	nwords = _bitstr_data_words(b1);
+	for (i = 0; i < nwords; i++)
+		w1[i] |= ~w2[i];
 }
 
 /*
@@ -746,6 +787,72 @@ hweight(uint64_t w)
 }
 #endif
 
+/*
+ * Count the bits set in the first nwords words of w. Four independent
+ * accumulators keep the popcounts from serializing on one register.
+ */
+BIT_KERNEL_CLONES
+static int64_t _bit_count_words(const bitstr_t *w, int64_t nwords)
+{
+	int64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, i;
+
+	for (i = 0; (i + 4) <= nwords; i += 4) {
+		c0 += hweight(w[i]);
+		c1 += hweight(w[i + 1]);
+		c2 += hweight(w[i + 2]);
+		c3 += hweight(w[i + 3]);
+	}
+	for ( ; i < nwords; i++)
+		c0 += hweight(w[i]);
+
+	return c0 + c1 + c2 + c3;
+}
+
+/*
+ * Count the bits set in both w1 and w2 over their first nwords words,
+ * without materializing the intersection.
+ */
+BIT_KERNEL_CLONES
+static int64_t _bit_and_count_words(const bitstr_t *w1, const bitstr_t *w2,
+				    int64_t nwords)
+{
+	int64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, i;
+
+	for (i = 0; (i + 4) <= nwords; i += 4) {
+		c0 += hweight(w1[i] & w2[i]);
+		c1 += hweight(w1[i + 1] & w2[i + 1]);
+		c2 += hweight(w1[i + 2] & w2[i + 2]);
+		c3 += hweight(w1[i + 3] & w2[i + 3]);
+	}
+	for ( ; i < nwords; i++)
+		c0 += hweight(w1[i] & w2[i]);
+
+	return c0 + c1 + c2 + c3;
+}
+
+/*
+ * Return true if w1 and w2 share any set bit in their first nwords words.
+ * Words are tested in blocks of four so the common no-overlap case runs
+ * without a branch per word.
+ */
+static bool _bit_and_any_words(const bitstr_t *w1, const bitstr_t *w2,
+			       int64_t nwords)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= nwords; i += 4) {
+		if ((w1[i] & w2[i]) | (w1[i + 1] & w2[i + 1]) |
+		    (w1[i + 2] & w2[i + 2]) | (w1[i + 3] & w2[i + 3]))
+			return true;
+	}
+	for ( ; i < nwords; i++) {
+		if (w1[i] & w2[i])
+			return true;
+	}
+
+	return false;
+}
+
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -754,20 +861,18 @@ hweight(uint64_t w)
 int32_t
 bit_set_count(bitstr_t *b)
 {
-	int32_t count = 0;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	const bitstr_t *w = b + BITSTR_OVERHEAD;
+	bitoff_t bit_cnt;
+	int64_t full_words, count;
 
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b, bit))
-			count++;
-	}
+	full_words = bit_cnt >> BITSTR_SHIFT;
+	count = _bit_count_words(w, full_words);
+	if (bit_cnt & BITSTR_MAXPOS)
+		count += hweight(w[full_words] & _bit_tail_mask(bit_cnt));
+
 	return count;
 }
 
@@ -794,8 +899,10 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 		if (bit_test(b, bit))
 			count++;
 	}
-	for (; (bit + word_size) <= end ; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
+	if ((bit + word_size) <= end) {
+		int64_t nwords = (end - bit) / word_size;
+		count += _bit_count_words(b + _bit_word(bit), nwords);
+		bit += nwords * word_size;
 	}
 	for ( ; bit < end; bit++) {
 		if (bit_test(b, bit))
@@ -807,35 +914,26 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 
 static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 {
-	int32_t count = 0;
-	int64_t anded;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	const bitstr_t *w1 = b1 + BITSTR_OVERHEAD, *w2 = b2 + BITSTR_OVERHEAD;
+	bitstr_t tail = 0;
+	bitoff_t bit_cnt;
+	int64_t full_words;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
-		if (count_it)
-			count += hweight(anded);
-		else if (anded)
-			return 1;
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b1, bit) && bit_test(b2, bit)) {
-			if (count_it)
-				count++;
-			else
-				return 1;
-		}
-	}
+	full_words = bit_cnt >> BITSTR_SHIFT;
+	if (bit_cnt & BITSTR_MAXPOS)
+		tail = w1[full_words] & w2[full_words] &
+		       _bit_tail_mask(bit_cnt);
 
-	return count;
+	if (count_it)
+		return _bit_and_count_words(w1, w2, full_words) +
+		       hweight(tail);
+
+	return (tail || _bit_and_any_words(w1, w2, full_words));
 }
 
 /*
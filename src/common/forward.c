@@ -52,9 +52,18 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define FWD_FAIL_MEMORY		300	/* seconds a failure marks node slow */
+#define FWD_SLOW_FACTOR		4	/* slow if RTT over this * mean RTT */
+#define FWD_SLOW_MIN_USEC	50000	/* never slow with an RTT below this */
+#define FWD_WIDE_MSG_SIZE	(64 * 1024) /* narrow tree above this size */
+#define FWD_MIN_TREE_WIDTH	4
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -63,8 +72,26 @@ typedef struct {
 	int timeout;
 	hostlist_t tree_hl;
 	pthread_mutex_t *tree_mutex;
+	uint16_t tree_width;
 } fwd_tree_t;
 
+/* Response history of a node this process sent tree messages to */
+typedef struct {
+	char *name;
+	uint32_t rtt_usec;	/* moving average of round trips as a leaf */
+	time_t fail_time;	/* last failed send or forward */
+} fwd_node_hist_t;
+
+/*
+ * Only kept once forward_adaptive_init() was called, which slurmctld does.
+ * Everything below is protected by hist_mutex.
+ */
+static pthread_mutex_t hist_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *node_hist = NULL;
+static uint32_t rtt_mean_usec = 0;	/* moving average over all nodes */
+static uint32_t fwd_timeout_hist[FORWARD_HIST_CNT];
+static uint32_t fwd_reordered = 0;
+
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count);
@@ -73,6 +100,216 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+static void _hist_id(void *item, const char **key, uint32_t *key_len)
+{
+	fwd_node_hist_t *hist = item;
+
+	*key = hist->name;
+	*key_len = strlen(hist->name);
+}
+
+static void _hist_free(void *item)
+{
+	fwd_node_hist_t *hist = item;
+
+	xfree(hist->name);
+	xfree(hist);
+}
+
+/* Call with hist_mutex locked */
+static fwd_node_hist_t *_hist_find(const char *name, bool create)
+{
+	fwd_node_hist_t *hist = xhash_get_str(node_hist, name);
+
+	if (!hist && create) {
+		hist = xmalloc(sizeof(*hist));
+		hist->name = xstrdup(name);
+		xhash_add(node_hist, hist);
+	}
+	return hist;
+}
+
+/* Moving average with a weight of 1/8 for the new sample */
+static uint32_t _rtt_avg(uint32_t avg, uint32_t sample)
+{
+	if (!avg)
+		return sample;
+	return (uint32_t) (((uint64_t) avg * 7 + sample) / 8);
+}
+
+/*
+ * Cost of making a node an interior node of the tree, lower is better.
+ * Call with hist_mutex locked.
+ */
+static uint64_t _node_cost(const char *name, time_t now)
+{
+	fwd_node_hist_t *hist = _hist_find(name, false);
+
+	if (!hist)
+		return rtt_mean_usec;
+	if (hist->fail_time && ((now - hist->fail_time) < FWD_FAIL_MEMORY))
+		return UINT64_MAX;
+	return hist->rtt_usec ? hist->rtt_usec : rtt_mean_usec;
+}
+
+static bool _cost_is_slow(uint64_t cost)
+{
+	if (cost == UINT64_MAX)
+		return true;
+	return ((cost > FWD_SLOW_MIN_USEC) &&
+		(cost > ((uint64_t) rtt_mean_usec * FWD_SLOW_FACTOR)));
+}
+
+/*
+ * The first host of a split hostlist receives the message directly and
+ * forwards it to the rest. If that host is known to be slow or failed
+ * recently, put the cheapest host of the list in front instead so the bad
+ * one ends up as a leaf.
+ */
+static void _promote_fast_head(hostlist_t *hl)
+{
+	hostlist_iterator_t itr;
+	hostlist_t new_hl;
+	char *name, *best = NULL;
+	uint64_t cost, best_cost;
+	time_t now = time(NULL);
+
+	if (hostlist_count(*hl) < 2)
+		return;
+
+	slurm_mutex_lock(&hist_mutex);
+	name = hostlist_nth(*hl, 0);
+	best_cost = _node_cost(name, now);
+	free(name);
+	if (!_cost_is_slow(best_cost)) {
+		slurm_mutex_unlock(&hist_mutex);
+		return;
+	}
+
+	itr = hostlist_iterator_create(*hl);
+	while ((name = hostlist_next(itr))) {
+		if ((cost = _node_cost(name, now)) < best_cost) {
+			free(best);
+			best = name;
+			best_cost = cost;
+		} else
+			free(name);
+	}
+	hostlist_iterator_destroy(itr);
+
+	if (!best || _cost_is_slow(best_cost)) {
+		slurm_mutex_unlock(&hist_mutex);
+		free(best);
+		return;
+	}
+	fwd_reordered++;
+	slurm_mutex_unlock(&hist_mutex);
+
+	new_hl = hostlist_create(best);
+	while ((name = hostlist_shift(*hl))) {
+		if (xstrcmp(name, best))
+			hostlist_push_host(new_hl, name);
+		free(name);
+	}
+	free(best);
+	hostlist_destroy(*hl);
+	*hl = new_hl;
+}
+
+/*
+ * Record the outcome of sending a tree message to a direct child: the
+ * round trip time if it was a leaf, failures of it or of any node it
+ * forwarded to, and how much of the timeout the exchange used.
+ */
+static void _note_tree_send(const char *name, int fwd_cnt, int tree_width,
+			    List ret_list, long usec, int timeout)
+{
+	ret_data_info_t *ret_data_info;
+	fwd_node_hist_t *hist;
+	ListIterator itr;
+	time_t now = time(NULL);
+	int steps, pct, bucket;
+
+	/* Same wait as _send_and_recv_msgs(), which grows with the subtree */
+	if (timeout <= 0)
+		timeout = slurm_conf.msg_timeout * 1000;
+	if (fwd_cnt > 0) {
+		if (!tree_width)
+			tree_width = slurm_conf.tree_width;
+		steps = fwd_cnt + 1;
+		if (tree_width)
+			steps /= tree_width;
+		timeout = (slurm_conf.msg_timeout * 1000 * steps) +
+			  (timeout * (steps + 1));
+	}
+	pct = timeout ? (usec / 10 / timeout) : 0;
+
+	if (pct < 10)
+		bucket = 0;
+	else if (pct < 25)
+		bucket = 1;
+	else if (pct < 50)
+		bucket = 2;
+	else if (pct < 100)
+		bucket = 3;
+	else
+		bucket = 4;
+
+	slurm_mutex_lock(&hist_mutex);
+	if (!node_hist) {
+		slurm_mutex_unlock(&hist_mutex);
+		return;
+	}
+	fwd_timeout_hist[bucket]++;
+
+	if (ret_list) {
+		itr = list_iterator_create(ret_list);
+		while ((ret_data_info = list_next(itr))) {
+			if (!ret_data_info->node_name)
+				continue;
+			if (ret_data_info->type == RESPONSE_FORWARD_FAILED) {
+				hist = _hist_find(ret_data_info->node_name,
+						  true);
+				hist->fail_time = now;
+			} else if (!fwd_cnt &&
+				   !xstrcmp(ret_data_info->node_name, name)) {
+				hist = _hist_find(name, true);
+				hist->rtt_usec = _rtt_avg(hist->rtt_usec, usec);
+				hist->fail_time = 0;
+				rtt_mean_usec = _rtt_avg(rtt_mean_usec, usec);
+			}
+		}
+		list_iterator_destroy(itr);
+	}
+	slurm_mutex_unlock(&hist_mutex);
+}
+
+/* Narrower trees for large messages, each hop sends fewer copies */
+static uint16_t _tree_width_for_size(uint16_t tree_width, uint32_t size)
+{
+	uint32_t width;
+
+	if (size <= FWD_WIDE_MSG_SIZE)
+		return tree_width;
+	width = ((uint64_t) tree_width * FWD_WIDE_MSG_SIZE) / size;
+	return MAX(width, MIN(tree_width, FWD_MIN_TREE_WIDTH));
+}
+
+static uint32_t _msg_body_size(slurm_msg_t *msg)
+{
+	slurm_msg_t tmp_msg = *msg;
+	buf_t *buffer = init_buf(BUF_SIZE);
+	uint32_t size;
+
+	if (tmp_msg.protocol_version == NO_VAL16)
+		tmp_msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	pack_msg(&tmp_msg, buffer);
+	size = get_buf_offset(buffer);
+	free_buf(buffer);
+
+	return size;
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -346,12 +583,14 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	DEF_TIMERS;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
 	send_msg.flags = fwd_tree->orig_msg->flags;
 	send_msg.data = fwd_tree->orig_msg->data;
 	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
+	send_msg.forward.tree_width = fwd_tree->tree_width;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
@@ -383,8 +622,14 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		START_TIMER;
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
+		END_TIMER;
+		if (node_hist)
+			_note_tree_send(name, send_msg.forward.cnt,
+					send_msg.forward.tree_width, ret_list,
+					DELTA_TIMER, fwd_tree->timeout);
 
 		xfree(send_msg.forward.nodelist);
 
@@ -560,6 +805,7 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 
 		forward_init(&fwd_msg->header.forward);
 		fwd_msg->header.forward.nodelist = buf;
+		fwd_msg->header.forward.tree_width = header->forward.tree_width;
 		slurm_thread_create_detached(NULL, _forward_thread, fwd_msg);
 	}
 }
@@ -638,6 +884,7 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	int host_count = 0;
 	hostlist_t* sp_hl;
 	int hl_count = 0;
+	uint16_t tree_width;
 
 	xassert(hl);
 	xassert(msg);
@@ -645,11 +892,23 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	hostlist_uniq(hl);
 	host_count = hostlist_count(hl);
 
-	if (route_g_split_hostlist(hl, &sp_hl, &hl_count,
-				   msg->forward.tree_width)) {
+	tree_width = msg->forward.tree_width;
+	if (node_hist && !tree_width) {
+		tree_width = slurm_conf.tree_width;
+		/* Only matters if some nodes will forward the message */
+		if (host_count > tree_width)
+			tree_width = _tree_width_for_size(
+				tree_width, _msg_body_size(msg));
+	}
+
+	if (route_g_split_hostlist(hl, &sp_hl, &hl_count, tree_width)) {
 		error("unable to split forward hostlist");
 		return NULL;
 	}
+	if (node_hist) {
+		for (int j = 0; j < hl_count; j++)
+			_promote_fast_head(&sp_hl[j]);
+	}
 	slurm_mutex_init(&tree_mutex);
 	slurm_cond_init(&notify, NULL);
 
@@ -662,6 +921,7 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	fwd_tree.notify = &notify;
 	fwd_tree.p_thr_count = &thr_count;
 	fwd_tree.tree_mutex = &tree_mutex;
+	fwd_tree.tree_width = tree_width;
 
 	_start_msg_tree_internal(NULL, sp_hl, &fwd_tree, hl_count);
 
@@ -686,6 +946,38 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	return ret_list;
 }
 
+extern void forward_adaptive_init(void)
+{
+	slurm_mutex_lock(&hist_mutex);
+	if (!node_hist)
+		node_hist = xhash_init(_hist_id, _hist_free);
+	slurm_mutex_unlock(&hist_mutex);
+}
+
+extern void forward_adaptive_fini(void)
+{
+	slurm_mutex_lock(&hist_mutex);
+	xhash_free(node_hist);
+	rtt_mean_usec = 0;
+	slurm_mutex_unlock(&hist_mutex);
+}
+
+extern void forward_pack_stats(buf_t *buffer)
+{
+	slurm_mutex_lock(&hist_mutex);
+	pack32_array(fwd_timeout_hist, FORWARD_HIST_CNT, buffer);
+	pack32(fwd_reordered, buffer);
+	slurm_mutex_unlock(&hist_mutex);
+}
+
+extern void forward_reset_stats(void)
+{
+	slurm_mutex_lock(&hist_mutex);
+	memset(fwd_timeout_hist, 0, sizeof(fwd_timeout_hist));
+	fwd_reordered = 0;
+	slurm_mutex_unlock(&hist_mutex);
+}
+
 /*
  * mark_as_failed_forward- mark a node as failed and add it to "ret_list"
  *
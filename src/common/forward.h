@@ -40,8 +40,16 @@
 #define _FORWARD_H
 
 #include <stdint.h>
+#include "src/common/pack.h"
 #include "src/common/slurm_protocol_api.h"
 
+/*
+ * Buckets of the forward timeout histogram, the share of the timeout used
+ * by each exchange with a direct child of the tree:
+ * <10%, 10-25%, 25-50%, 50-100% and timed out.
+ */
+#define FORWARD_HIST_CNT 5
+
 /*
  * forward_init    - initialize forward structure
  * IN: forward     - forward_t *   - struct to store forward info
@@ -111,6 +119,22 @@ extern void mark_as_failed_forward(List *ret_list, char *node_name, int err);
 
 extern void forward_wait(slurm_msg_t *msg);
 
+/*
+ * forward_adaptive_init - keep a response time and failure history of the
+ *	nodes start_msg_tree() sends to and use it to build the tree: nodes
+ *	that are slow or failed recently are kept out of the positions that
+ *	forward to others and large messages get a narrower tree.
+ */
+extern void forward_adaptive_init(void);
+extern void forward_adaptive_fini(void);
+
+/*
+ * forward_pack_stats - pack the forward timeout histogram (FORWARD_HIST_CNT
+ *	uint32_t) and the count of subtrees given a different head node
+ */
+extern void forward_pack_stats(buf_t *buffer);
+extern void forward_reset_stats(void);
+
 /*
  * no_resp_forward - Used to respond for nodes not able to respond since
  *                   the parent had failed in some way
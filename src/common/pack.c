@@ -107,6 +107,7 @@ strong_alias(unpackstr_xmalloc_escaped, slurm_unpackstr_xmalloc_escaped);
 strong_alias(unpackstr_xmalloc_chooser, slurm_unpackstr_xmalloc_chooser);
 strong_alias(packstr_array,	slurm_packstr_array);
 strong_alias(unpackstr_array,	slurm_unpackstr_array);
+strong_alias(skipstr_array,	slurm_skipstr_array);
 strong_alias(packmem_array,	slurm_packmem_array);
 strong_alias(unpackmem_array,	slurm_unpackmem_array);
 
@@ -1068,6 +1069,39 @@ int unpackstr_array(char ***valp, uint32_t *size_valp, buf_t *buffer)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Given a buffer containing an array of strings packed by packstr_array(),
+ * adjust the buffer counters past it without copying the strings.
+ * RET SLURM_SUCCESS if unpackstr_array() would accept the same data
+ */
+int skipstr_array(buf_t *buffer)
+{
+	int i;
+	uint32_t ns, cnt, len;
+
+	if (remaining_buf(buffer) < sizeof(ns))
+		return SLURM_ERROR;
+
+	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
+	cnt = ntohl(ns);
+	buffer->processed += sizeof(ns);
+
+	if (cnt > MAX_ARRAY_LEN_MEDIUM)
+		return SLURM_ERROR;
+	for (i = 0; i < cnt; i++) {
+		if (remaining_buf(buffer) < sizeof(ns))
+			return SLURM_ERROR;
+		memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
+		len = ntohl(ns);
+		buffer->processed += sizeof(ns);
+		if ((len > MAX_ARRAY_LEN_LARGE) ||
+		    (remaining_buf(buffer) < len))
+			return SLURM_ERROR;
+		buffer->processed += len;
+	}
+	return SLURM_SUCCESS;
+}
+
 /*
  * Given a pointer to memory (valp), size (size_val), and buffer,
  * store the memory contents into the buffer
@@ -137,6 +137,7 @@ extern int unpackstr_xmalloc_chooser(char **valp, uint32_t *size_valp,
 
 extern void packstr_array(char **valp, uint32_t size_val, buf_t *buffer);
 extern int unpackstr_array(char ***valp, uint32_t* size_val, buf_t *buffer);
+extern int skipstr_array(buf_t *buffer);
 
 extern void packmem_array(char *valp, uint32_t size_val, buf_t *buffer);
 extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
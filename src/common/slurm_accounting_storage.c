@@ -192,6 +192,10 @@ typedef struct slurm_acct_storage_ops {
 	int  (*job_suspend)        (void *db_conn, job_record_t *job_ptr);
 	List (*get_jobs_cond)      (void *db_conn, uint32_t uid,
 				    slurmdb_job_cond_t *job_cond);
+	int (*get_jobs_cond_cb)    (void *db_conn, uint32_t uid,
+				    slurmdb_job_cond_t *job_cond,
+				    int (*callback)(List job_list, void *arg),
+				    void *arg);
 	int (*archive_dump)        (void *db_conn,
 				    slurmdb_archive_cond_t *arch_cond);
 	int (*archive_load)        (void *db_conn,
@@ -276,6 +280,7 @@ static const char *syms[] = {
 	"jobacct_storage_p_step_complete",
 	"jobacct_storage_p_suspend",
 	"jobacct_storage_p_get_jobs_cond",
+	"jobacct_storage_p_get_jobs_cond_cb",
 	"jobacct_storage_p_archive",
 	"jobacct_storage_p_archive_load",
 	"acct_storage_p_update_shares_used",
@@ -966,6 +971,23 @@ extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 	return ret_list;
 }
 
+/*
+ * get info from the storage a chunk at a time
+ * IN callback - given each chunk of slurmdb_job_rec_t *'s as it is read,
+ *		 whatever is left in the List on return is freed
+ * RET SLURM_SUCCESS or an error code
+ */
+extern int jobacct_storage_g_get_jobs_cond_cb(void *db_conn, uint32_t uid,
+					      slurmdb_job_cond_t *job_cond,
+					      int (*callback)(List job_list,
+							      void *arg),
+					      void *arg)
+{
+	if (slurm_acct_storage_init() < 0)
+		return SLURM_ERROR;
+	return (*(ops.get_jobs_cond_cb))(db_conn, uid, job_cond, callback, arg);
+}
+
 /*
  * expire old info from the storage
  */
@@ -644,6 +644,20 @@ extern int jobacct_storage_g_job_suspend(void *db_conn,
 extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 					    slurmdb_job_cond_t *job_cond);
 
+/*
+ * get info from the storage a chunk at a time, so the whole answer never
+ * has to be held in memory
+ * IN callback - given each chunk of slurmdb_job_rec_t *'s as it is read,
+ *		 whatever is left in the List on return is freed.  Anything
+ *		 but SLURM_SUCCESS stops the query.
+ * RET SLURM_SUCCESS or an error code
+ */
+extern int jobacct_storage_g_get_jobs_cond_cb(void *db_conn, uint32_t uid,
+					      slurmdb_job_cond_t *job_cond,
+					      int (*callback)(List job_list,
+							      void *arg),
+					      void *arg);
+
 /*
  * expire old info from the storage
  */
@@ -365,7 +365,7 @@ static int _slurm_cred_fini(void)
 	return rc;
 }
 
-static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
+static int _fill_cred_gids(slurm_cred_t *cred, char *pw_name)
 {
 	struct passwd pwd, *result;
 	char buffer[PW_BUF_SIZE];
@@ -375,12 +375,11 @@ static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
 		return SLURM_SUCCESS;
 
 	xassert(cred);
-	xassert(arg);
 
-	rc = slurm_getpwuid_r(arg->uid, &pwd, buffer, PW_BUF_SIZE, &result);
+	rc = slurm_getpwuid_r(cred->uid, &pwd, buffer, PW_BUF_SIZE, &result);
 	if (rc || !result) {
 		error("%s: getpwuid failed for uid=%u",
-		      __func__, arg->uid);
+		      __func__, cred->uid);
 		return SLURM_ERROR;
 	}
 
@@ -389,8 +388,8 @@ static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
 	cred->pw_dir = xstrdup(result->pw_dir);
 	cred->pw_shell = xstrdup(result->pw_shell);
 
-	cred->ngids = group_cache_lookup(arg->uid, arg->gid,
-					 arg->pw_name, &cred->gids);
+	cred->ngids = group_cache_lookup(cred->uid, cred->gid,
+					 pw_name, &cred->gids);
 
 	return SLURM_SUCCESS;
 }
@@ -564,14 +563,72 @@ slurm_cred_ctx_key_update(slurm_cred_ctx_t ctx, const char *path)
 }
 
 
+/*
+ * Look up the user's identity and sign the credential.
+ * pw_name IN - user name to look groups up for, NULL to resolve it from uid
+ */
+static int _slurm_cred_finish(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+			      char *pw_name, uint16_t protocol_version)
+{
+	int rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&cred->mutex);
+	xassert(cred->magic == CRED_MAGIC);
+
+	if (_fill_cred_gids(cred, pw_name) != SLURM_SUCCESS) {
+		rc = SLURM_ERROR;
+		goto fini;
+	}
+
+	if (enable_nss_slurm) {
+		if (cred->ngids) {
+			cred->gr_names = xcalloc(cred->ngids, sizeof(char *));
+			for (int i = 0; i < cred->ngids; i++) {
+				cred->gr_names[i] =
+					gid_to_string(cred->gids[i]);
+			}
+		}
+	}
+	cred->ctime = time(NULL);
+
+	slurm_mutex_lock(&ctx->mutex);
+	xassert(ctx->magic == CRED_CTX_MAGIC);
+	xassert(ctx->type == SLURM_CRED_CREATOR);
+	if (_slurm_cred_sign(ctx, cred, protocol_version) < 0)
+		rc = SLURM_ERROR;
+	slurm_mutex_unlock(&ctx->mutex);
+
+fini:
+	slurm_mutex_unlock(&cred->mutex);
+	return rc;
+}
+
 slurm_cred_t *
 slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 		  uint16_t protocol_version)
+{
+	slurm_cred_t *cred;
+
+	xassert(ctx != NULL);
+	xassert(arg != NULL);
+
+	if (!(cred = slurm_cred_create_unsigned(arg)))
+		return NULL;
+
+	if (_slurm_cred_finish(ctx, cred, arg->pw_name, protocol_version)) {
+		slurm_cred_destroy(cred);
+		return NULL;
+	}
+
+	return cred;
+}
+
+slurm_cred_t *
+slurm_cred_create_unsigned(slurm_cred_arg_t *arg)
 {
 	slurm_cred_t *cred = NULL;
 	int i = 0, sock_recs = 0;
 
-	xassert(ctx != NULL);
 	xassert(arg != NULL);
 	if (_slurm_cred_init() < 0)
 		return NULL;
@@ -627,36 +684,36 @@ slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 	cred->job_hostlist    = xstrdup(arg->job_hostlist);
 	cred->ctime  = time(NULL);
 
-	if (_fill_cred_gids(cred, arg) != SLURM_SUCCESS)
-		goto fail;
+	slurm_mutex_unlock(&cred->mutex);
 
-	if (enable_nss_slurm) {
-		if (cred->ngids) {
-			cred->gr_names = xcalloc(cred->ngids, sizeof(char *));
-			for (int i = 0; i < cred->ngids; i++) {
-				cred->gr_names[i] =
-					gid_to_string(cred->gids[i]);
-			}
-		}
-	}
+	return cred;
+}
 
-	slurm_mutex_lock(&ctx->mutex);
-	xassert(ctx->magic == CRED_CTX_MAGIC);
-	xassert(ctx->type == SLURM_CRED_CREATOR);
-	if (_slurm_cred_sign(ctx, cred, protocol_version) < 0) {
-		slurm_mutex_unlock(&ctx->mutex);
-		goto fail;
-	}
+int
+slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+		uint16_t protocol_version)
+{
+	xassert(ctx != NULL);
+	xassert(cred != NULL);
 
-	slurm_mutex_unlock(&ctx->mutex);
-	slurm_mutex_unlock(&cred->mutex);
+	if (_slurm_cred_init() < 0)
+		return SLURM_ERROR;
 
-	return cred;
+	return _slurm_cred_finish(ctx, cred, NULL, protocol_version);
+}
 
-fail:
+bool
+slurm_cred_is_signed(slurm_cred_t *cred)
+{
+	bool is_signed;
+
+	xassert(cred != NULL);
+
+	slurm_mutex_lock(&cred->mutex);
+	is_signed = (cred->signature != NULL);
 	slurm_mutex_unlock(&cred->mutex);
-	slurm_cred_destroy(cred);
-	return NULL;
+
+	return is_signed;
 }
 
 slurm_cred_t *
@@ -787,7 +844,7 @@ slurm_cred_faker(slurm_cred_arg_t *arg)
 			cred->signature[i] = 'a' + (rand() & 0xf);
 	}
 
-	(void) _fill_cred_gids(cred, arg);
+	(void) _fill_cred_gids(cred, arg->pw_name);
 
 	slurm_mutex_unlock(&cred->mutex);
 	return cred;
@@ -194,6 +194,30 @@ int slurm_cred_fini(void);
 slurm_cred_t *slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 				uint16_t protocol_version);
 
+/*
+ * Create a slurm credential using the values in `arg' without signing it.
+ * No user or group lookups are done, so this is cheap and `arg' may point
+ * into data that is only valid while the caller holds some lock.
+ *
+ * The credential must be passed to slurm_cred_sign() before it is packed.
+ *
+ * Returns NULL on failure.
+ */
+slurm_cred_t *slurm_cred_create_unsigned(slurm_cred_arg_t *arg);
+
+/*
+ * Complete a credential from slurm_cred_create_unsigned(): look up the
+ * user's identity and groups, then sign it with the creator's key.
+ * The creation time is reset to the time of signing.
+ *
+ * Returns SLURM_SUCCESS or SLURM_ERROR.
+ */
+int slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+		    uint16_t protocol_version);
+
+/* Return true if the credential carries a signature */
+bool slurm_cred_is_signed(slurm_cred_t *cred);
+
 /*
  * Copy a slurm credential.
  * Returns NULL on failure.
@@ -1490,6 +1490,18 @@ extern void slurm_free_kill_job_msg(kill_job_msg_t * msg)
 	}
 }
 
+extern void slurm_free_terminate_jobs_msg(terminate_jobs_msg_t *msg)
+{
+	int i;
+
+	if (msg) {
+		for (i = 0; i < msg->job_cnt; i++)
+			slurm_free_kill_job_msg(msg->kill_msgs[i]);
+		xfree(msg->kill_msgs);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_task_exit_msg(task_exit_msg_t * msg)
 {
 	if (msg) {
@@ -1755,6 +1767,7 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		xfree(msg->fwd_timeout_hist);
 		xfree(msg);
 	}
 }
@@ -4198,6 +4211,7 @@ extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr)
 			_free_all_job_info(job_buffer_ptr);
 			xfree(job_buffer_ptr->job_array);
 		}
+		xfree(job_buffer_ptr->purged_job_ids);
 		xfree(job_buffer_ptr);
 	}
 }
@@ -5055,6 +5069,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_TERMINATE_JOB:
 		slurm_free_kill_job_msg(data);
 		break;
+	case REQUEST_TERMINATE_JOBS:
+		slurm_free_terminate_jobs_msg(data);
+		break;
 	case REQUEST_JOB_ID:
 		slurm_free_job_id_request_msg(data);
 		break;
@@ -5671,6 +5688,8 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:				/* 6019 */
 		return "RESPONSE_PROLOG_EXECUTING";
+	case REQUEST_TERMINATE_JOBS:				/* 6020 */
+		return "REQUEST_TERMINATE_JOBS";
 
 	case SRUN_PING:						/* 7001 */
 		return "SRUN_PING";
@@ -416,6 +416,7 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,	/* 6019 */
+	REQUEST_TERMINATE_JOBS,
 
 	REQUEST_PERSIST_INIT = 6500,
 
@@ -1000,6 +1001,16 @@ typedef struct kill_job_msg {
 	time_t   time;		/* slurmctld's time of request */
 } kill_job_msg_t;
 
+/*
+ * Several REQUEST_TERMINATE_JOB or REQUEST_KILL_* messages bound for the same
+ * set of nodes, coalesced by slurmctld's agent into a single RPC.
+ */
+typedef struct terminate_jobs_msg {
+	uint32_t job_cnt;
+	kill_job_msg_t **kill_msgs;
+	uint16_t msg_type;	/* type of each of the kill_msgs */
+} terminate_jobs_msg_t;
+
 typedef struct reattach_tasks_request_msg {
 	uint16_t     num_resp_port;
 	uint16_t    *resp_port; /* array of available response ports */
@@ -1494,6 +1505,7 @@ extern void slurm_free_reattach_tasks_request_msg(
 extern void slurm_free_reattach_tasks_response_msg(
 		reattach_tasks_response_msg_t * msg);
 extern void slurm_free_kill_job_msg(kill_job_msg_t * msg);
+extern void slurm_free_terminate_jobs_msg(terminate_jobs_msg_t *msg);
 extern void slurm_free_job_step_kill_msg(job_step_kill_msg_t * msg);
 extern void slurm_free_epilog_complete_msg(epilog_complete_msg_t * msg);
 extern void slurm_free_srun_job_complete_msg(srun_job_complete_msg_t * msg);
@@ -2681,6 +2681,57 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_terminate_jobs_msg(terminate_jobs_msg_t *msg, buf_t *buffer,
+				     uint16_t protocol_version)
+{
+	int i;
+
+	xassert(msg);
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack16(msg->msg_type, buffer);
+		pack32(msg->job_cnt, buffer);
+		for (i = 0; i < msg->job_cnt; i++)
+			_pack_kill_job_msg(msg->kill_msgs[i], buffer,
+					   protocol_version);
+	}
+}
+
+static int _unpack_terminate_jobs_msg(terminate_jobs_msg_t **msg,
+				      buf_t *buffer, uint16_t protocol_version)
+{
+	terminate_jobs_msg_t *tmp_ptr;
+	uint32_t i, job_cnt;
+
+	xassert(msg);
+	tmp_ptr = xmalloc(sizeof(terminate_jobs_msg_t));
+	*msg = tmp_ptr;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack16(&tmp_ptr->msg_type, buffer);
+		safe_unpack32(&job_cnt, buffer);
+		safe_xcalloc(tmp_ptr->kill_msgs, job_cnt,
+			     sizeof(kill_job_msg_t *));
+		/* Only count fully unpacked entries so they can be freed */
+		for (i = 0; i < job_cnt; i++) {
+			if (_unpack_kill_job_msg(&tmp_ptr->kill_msgs[i], buffer,
+						 protocol_version))
+				goto unpack_error;
+			tmp_ptr->job_cnt++;
+		}
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_terminate_jobs_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_epilog_comp_msg(epilog_complete_msg_t * msg, buf_t *buffer,
 		      uint16_t protocol_version)
@@ -3280,6 +3331,12 @@ _unpack_job_info_msg(job_info_msg_t ** msg, buf_t *buffer,
 						     protocol_version))
 				goto unpack_error;
 		}
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			safe_unpackbool(&(*msg)->delta, buffer);
+			safe_unpack32_array(&(*msg)->purged_job_ids,
+					    &(*msg)->purged_cnt, buffer);
+		}
 	} else {
 		error("_unpack_job_info_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -10559,6 +10616,23 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				safe_unpack32(&msg->bf_slice_copied, buffer);
+				safe_unpack32(&msg->bf_slice_reused, buffer);
+				safe_unpack32(&msg->select_cache_hits, buffer);
+				safe_unpack32(&msg->select_cache_misses,
+					      buffer);
+				safe_unpack32(&msg->decay_cycle_counter,
+					      buffer);
+				safe_unpack32(&msg->decay_cycle_last, buffer);
+				safe_unpack32(&msg->decay_cycle_max, buffer);
+				safe_unpack64(&msg->decay_cycle_sum, buffer);
+				safe_unpack32_array(&msg->fwd_timeout_hist,
+						    &msg->fwd_timeout_hist_cnt,
+						    buffer);
+				safe_unpack32(&msg->fwd_reordered, buffer);
+			}
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
@@ -10587,6 +10661,14 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				     buffer);
 		if (uint32_tmp != msg->rpc_dump_count)
 			goto unpack_error;
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			safe_unpack32(&msg->agent_msgs_coalesced, buffer);
+			safe_unpack32(&msg->agent_pool_size, buffer);
+			safe_unpack32(&msg->agent_pool_busy, buffer);
+			safe_unpack32(&msg->agent_pool_queued, buffer);
+			safe_unpack32(&msg->agent_rpcs_started, buffer);
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -11491,6 +11573,10 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		_pack_kill_job_msg((kill_job_msg_t *) msg->data, buffer,
 				   msg->protocol_version);
 		break;
+	case REQUEST_TERMINATE_JOBS:
+		_pack_terminate_jobs_msg((terminate_jobs_msg_t *) msg->data,
+					 buffer, msg->protocol_version);
+		break;
 	case MESSAGE_EPILOG_COMPLETE:
 		_pack_epilog_comp_msg((epilog_complete_msg_t *) msg->data,
 				      buffer,
@@ -12149,6 +12235,11 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 					  buffer,
 					  msg->protocol_version);
 		break;
+	case REQUEST_TERMINATE_JOBS:
+		rc = _unpack_terminate_jobs_msg(
+			(terminate_jobs_msg_t **) &msg->data,
+			buffer, msg->protocol_version);
+		break;
 	case MESSAGE_EPILOG_COMPLETE:
 		rc = _unpack_epilog_comp_msg((epilog_complete_msg_t **)
 					     & (msg->data), buffer,
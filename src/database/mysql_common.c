@@ -50,6 +50,10 @@
 
 #define MAX_DEADLOCK_ATTEMPTS 10
 
+/* Limits of one multi-row insert, see mysql_db_insert_batch() */
+#define MAX_BATCH_ROWS 500
+#define MAX_BATCH_SIZE (1024 * 1024)
+
 static char *table_defs_table = "table_defs_table";
 
 typedef struct {
@@ -68,6 +72,18 @@ static void _destroy_db_key(void *arg)
 	}
 }
 
+static int _flush_batch(mysql_conn_t *mysql_conn);
+
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static void _discard_batch(mysql_conn_t *mysql_conn)
+{
+	xfree(mysql_conn->batch_head);
+	xfree(mysql_conn->batch_rows);
+	xfree(mysql_conn->batch_tail);
+	mysql_conn->batch_pos = NULL;
+	mysql_conn->batch_cnt = 0;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is set on function entry */
 static int _clear_results(MYSQL *db_conn)
 {
@@ -134,11 +150,17 @@ static MYSQL_RES *_get_last_result(MYSQL *db_conn)
 }
 
 /* NOTE: Ensure that mysql_conn->lock is set on function entry */
-static int _mysql_query_internal(MYSQL *db_conn, char *query)
+static int _mysql_query_internal(mysql_conn_t *mysql_conn, char *query)
 {
+	MYSQL *db_conn = mysql_conn->db_conn;
 	int rc = SLURM_SUCCESS;
 	int deadlock_attempt = 0;
 
+	/* Queued rows go first, later statements may depend on them */
+	if (mysql_conn->batch_cnt && _flush_batch(mysql_conn))
+		return SLURM_ERROR;
+	mysql_conn->trx_open = true;
+
 try_again:
 	if (!db_conn)
 		fatal("You haven't inited this storage yet.");
@@ -162,6 +184,13 @@ try_again:
 			 */
 			deadlock_attempt++;
 
+			/*
+			 * The victim of a deadlock loses its whole
+			 * transaction, not just this statement.
+			 */
+			if (mysql_conn->trx_check)
+				mysql_conn->trx_lost = true;
+
 			if (deadlock_attempt < MAX_DEADLOCK_ATTEMPTS) {
 				error("%s: deadlock detected attempt %u/%u: %d %s",
 				      __func__, deadlock_attempt,
@@ -202,6 +231,36 @@ end_it:
 	return rc;
 }
 
+/*
+ * Send the rows queued by mysql_db_insert_batch() as one statement.
+ * NOTE: Ensure that mysql_conn->lock is set on function entry
+ */
+static int _flush_batch(mysql_conn_t *mysql_conn)
+{
+	char *query = NULL;
+	int cnt = mysql_conn->batch_cnt;
+	int rc;
+
+	if (!cnt)
+		return SLURM_SUCCESS;
+
+	xstrfmtcat(query, "%s%s%s", mysql_conn->batch_head,
+		   mysql_conn->batch_rows, mysql_conn->batch_tail);
+	_discard_batch(mysql_conn);
+
+	if ((rc = _mysql_query_internal(mysql_conn, query))) {
+		/*
+		 * The callers that queued these rows were already told they
+		 * were stored, so the transaction must not be committed.
+		 */
+		error("%s: lost %d queued rows", __func__, cnt);
+		mysql_conn->trx_lost = true;
+	}
+	xfree(query);
+
+	return rc;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -707,6 +766,7 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 {
 	if (mysql_conn) {
 		mysql_db_close_db_connection(mysql_conn);
+		_discard_batch(mysql_conn);
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
 		slurm_mutex_destroy(&mysql_conn->lock);
@@ -836,7 +896,7 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 		storage_init = true;
 		if (mysql_conn->rollback)
 			mysql_autocommit(mysql_conn->db_conn, 0);
-		rc = _mysql_query_internal(mysql_conn->db_conn,
+		rc = _mysql_query_internal(mysql_conn,
 					   "SET session sql_mode='ANSI_QUOTES,"
 					   "NO_ENGINE_SUBSTITUTION';");
 	}
@@ -853,6 +913,11 @@ extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 			mysql_thread_end();
 		mysql_close(mysql_conn->db_conn);
 		mysql_conn->db_conn = NULL;
+		/* An open transaction and queued rows go with it */
+		_discard_batch(mysql_conn);
+		if (mysql_conn->trx_check && mysql_conn->trx_open)
+			mysql_conn->trx_lost = true;
+		mysql_conn->trx_open = false;
 	}
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return SLURM_SUCCESS;
@@ -880,7 +945,7 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	rc = _mysql_query_internal(mysql_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -898,7 +963,7 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
+	if (!(rc = _mysql_query_internal(mysql_conn, query)))
 		rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -935,13 +1000,22 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 	slurm_mutex_lock(&mysql_conn->lock);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
-	if (mysql_commit(mysql_conn->db_conn)) {
+	_flush_batch(mysql_conn);
+	if (mysql_conn->trx_lost) {
+		error("%s: transaction was lost, rolling back instead",
+		      __func__);
+		mysql_rollback(mysql_conn->db_conn);
+		mysql_conn->trx_lost = false;
+		errno = ESLURM_DB_CONNECTION;
+		rc = SLURM_ERROR;
+	} else if (mysql_commit(mysql_conn->db_conn)) {
 		error("mysql_commit failed: %d %s",
 		      mysql_errno(mysql_conn->db_conn),
 		      mysql_error(mysql_conn->db_conn));
 		errno = mysql_errno(mysql_conn->db_conn);
 		rc = SLURM_ERROR;
 	}
+	mysql_conn->trx_open = false;
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -956,6 +1030,9 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 	slurm_mutex_lock(&mysql_conn->lock);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
+	_discard_batch(mysql_conn);
+	mysql_conn->trx_lost = false;
+	mysql_conn->trx_open = false;
 	if (mysql_rollback(mysql_conn->db_conn)) {
 		error("mysql_commit failed: %d %s",
 		      mysql_errno(mysql_conn->db_conn),
@@ -980,7 +1057,7 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if (_mysql_query_internal(mysql_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
 		else if (last)
@@ -1004,13 +1081,35 @@ fini:
 	return result;
 }
 
+extern MYSQL_RES *mysql_db_query_stream(mysql_conn_t *mysql_conn, char *query)
+{
+	MYSQL_RES *result = NULL;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (_mysql_query_internal(mysql_conn, query) != SLURM_ERROR) {
+		result = mysql_use_result(mysql_conn->db_conn);
+		/*
+		 * Starting in MariaDB 10.2 many of the api commands started
+		 * setting errno erroneously.
+		 */
+		errno = 0;
+		if (!result && mysql_field_count(mysql_conn->db_conn)) {
+			/* should have returned data */
+			error("We should have gotten a result: '%m' '%s'",
+			      mysql_error(mysql_conn->db_conn));
+		}
+	}
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return result;
+}
+
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 {
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if ((rc = _mysql_query_internal(
-		     mysql_conn->db_conn, query)) != SLURM_ERROR)
+	if ((rc = _mysql_query_internal(mysql_conn, query)) != SLURM_ERROR)
 		rc = _clear_results(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -1021,7 +1120,7 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	uint64_t new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if (_mysql_query_internal(mysql_conn, query) != SLURM_ERROR)  {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
 			/* should have new id */
@@ -1034,6 +1133,47 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!mysql_conn->trx_check) {
+		char *query = xstrdup_printf("%s%s%s", head, row, tail);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		return rc;
+	}
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (mysql_conn->batch_cnt &&
+	    (xstrcmp(head, mysql_conn->batch_head) ||
+	     xstrcmp(tail, mysql_conn->batch_tail)))
+		rc = _flush_batch(mysql_conn);
+
+	if (!mysql_conn->batch_cnt) {
+		mysql_conn->batch_head = xstrdup(head);
+		mysql_conn->batch_tail = xstrdup(tail);
+		xstrfmtcatat(mysql_conn->batch_rows, &mysql_conn->batch_pos,
+			     "%s", row);
+	} else
+		xstrfmtcatat(mysql_conn->batch_rows, &mysql_conn->batch_pos,
+			     ", %s", row);
+	mysql_conn->batch_cnt++;
+	/* Losing the connection now loses an acknowledged row */
+	mysql_conn->trx_open = true;
+
+	if ((mysql_conn->batch_cnt >= MAX_BATCH_ROWS) ||
+	    ((mysql_conn->batch_pos - mysql_conn->batch_rows) >=
+	     MAX_BATCH_SIZE)) {
+		if (_flush_batch(mysql_conn))
+			rc = SLURM_ERROR;
+	}
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
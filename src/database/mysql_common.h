@@ -59,12 +59,22 @@ typedef enum {
 } slurm_mysql_plugin_type_t;
 
 typedef struct {
+	int batch_cnt;		/* rows queued by mysql_db_insert_batch() */
+	char *batch_head;	/* "insert into ... values " of queued rows */
+	char *batch_pos;	/* end of batch_rows */
+	char *batch_rows;
+	char *batch_tail;	/* "on duplicate key update ..." of queued rows */
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
 	pthread_mutex_t lock;
 	char *pre_commit_query;
 	bool rollback;
+	bool trx_check;		/* the owner commits after every request and
+				 * checks the result, see
+				 * mysql_db_insert_batch() */
+	bool trx_lost;		/* open transaction is gone, don't commit */
+	bool trx_open;		/* statements sent since commit/rollback */
 	List update_list;
 	int conn;
 } mysql_conn_t;
@@ -103,8 +113,38 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 				     char *query, bool last);
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Like mysql_db_query_ret() but the rows are read from the server as they are
+ * fetched instead of all at once, so a large result never has to fit in
+ * memory. No other query may be run on mysql_conn until the result is freed,
+ * check mysql_errno() after the last mysql_fetch_row().
+ */
+extern MYSQL_RES *mysql_db_query_stream(mysql_conn_t *mysql_conn, char *query);
+
 extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Queue one row of a multi-row "head (row), (row), ... tail" insert.
+ *
+ * Rows sharing the same head and tail are sent as one statement when the
+ * batch fills up, or before any other query, commit or rollback on this
+ * connection, so statement order is preserved.
+ *
+ * Rows are only queued when trx_check is set on the connection. A queued
+ * row is acknowledged before it is stored, so if it can't be stored the
+ * whole transaction is marked lost and mysql_db_commit() rolls it back and
+ * fails, which the owner has to report so the records are sent again. On
+ * other connections (autocommit, or commits on a timer that nobody checks)
+ * the row is inserted right away and errors are returned directly.
+ *
+ * IN head - "insert into ... (columns) values "
+ * IN row - "(value, ...)"
+ * IN tail - " on duplicate key update ...;" or ";"
+ * RET SLURM_SUCCESS or error from sending the batch this row completed
+ */
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
@@ -2714,6 +2714,17 @@ extern int get_cluster_dims(mysql_conn_t *mysql_conn, char *cluster_name,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Only let the mysql layer queue rows and fail lost transactions when every
+ * request is committed and the result sent back. With CommitDelay the
+ * commits come from a timer and nobody would hear about the lost records.
+ */
+static void _set_trx_check(mysql_conn_t *mysql_conn)
+{
+	mysql_conn->trx_check = (mysql_conn->rollback && slurmdbd_conf &&
+				 !slurmdbd_conf->commit_delay);
+}
+
 extern void *acct_storage_p_get_connection(
 	int conn_num, uint16_t *persist_conn_flags,
 	bool rollback, char *cluster_name)
@@ -2729,6 +2740,8 @@ extern void *acct_storage_p_get_connection(
 		return NULL;	/* Fix CLANG false positive error */
 	}
 
+	_set_trx_check(mysql_conn);
+
 	errno = SLURM_SUCCESS;
 	mysql_db_get_db_connection(mysql_conn, mysql_db_name, mysql_db_info);
 
@@ -2755,6 +2768,7 @@ extern int acct_storage_p_close_connection(mysql_conn_t **mysql_conn)
 extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 {
 	int rc = check_connection(mysql_conn);
+	int commit_rc = SLURM_SUCCESS;
 	List update_list = NULL;
 
 	/* always reset this here */
@@ -2779,7 +2793,6 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
 			/*
 			 * Handle anything here we were unable to do
 			 * because of rollback issues.
@@ -2788,22 +2801,22 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 				DB_DEBUG(DB_ASSOC, mysql_conn->conn,
 				         "query\n%s",
 				         mysql_conn->pre_commit_query);
-				rc = mysql_db_query(
+				commit_rc = mysql_db_query(
 					mysql_conn,
 					mysql_conn->pre_commit_query);
 			}
 
-			if (rc != SLURM_SUCCESS) {
+			if (commit_rc != SLURM_SUCCESS) {
 				if (mysql_db_rollback(mysql_conn))
 					error("rollback failed");
-			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
-			}
+			} else if ((commit_rc = mysql_db_commit(mysql_conn)))
+				error("commit failed");
 		}
+		/* CommitDelay may have changed with a reconfig */
+		_set_trx_check(mysql_conn);
 	}
 
-	if (commit && list_count(update_list)) {
+	if (commit && !commit_rc && list_count(update_list)) {
 		char *query = NULL;
 		MYSQL_RES *result = NULL;
 		MYSQL_ROW row;
@@ -2863,7 +2876,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	FREE_NULL_LIST(update_list);
 
-	return SLURM_SUCCESS;
+	return commit_rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
@@ -3380,6 +3393,39 @@ extern List jobacct_storage_p_get_jobs_cond(mysql_conn_t *mysql_conn,
 	return job_list;
 }
 
+/*
+ * get info from the storage a chunk at a time, the job query is read from
+ * a connection of its own so the steps of each job can be looked up while
+ * it is still being read.
+ */
+extern int jobacct_storage_p_get_jobs_cond_cb(mysql_conn_t *mysql_conn,
+					      uid_t uid,
+					      slurmdb_job_cond_t *job_cond,
+					      int (*callback)(List job_list,
+							      void *arg),
+					      void *arg)
+{
+	mysql_conn_t *stream_conn;
+	int rc;
+
+	if ((rc = check_connection(mysql_conn)) != SLURM_SUCCESS)
+		return rc;
+
+	stream_conn = create_mysql_conn(mysql_conn->conn, false,
+					mysql_conn->cluster_name);
+	if (mysql_db_get_db_connection(stream_conn, mysql_db_name,
+				       mysql_db_info) != SLURM_SUCCESS) {
+		destroy_mysql_conn(stream_conn);
+		return ESLURM_DB_CONNECTION;
+	}
+
+	rc = as_mysql_jobacct_process_get_jobs_cb(mysql_conn, stream_conn, uid,
+						  job_cond, callback, arg);
+	destroy_mysql_conn(stream_conn);
+
+	return rc;
+}
+
 /*
  * expire old info from the storage
  */
@@ -50,6 +50,20 @@ typedef struct {
 	bitstr_t *asked_bitmap;
 } local_cluster_t;
 
+/*
+ * When streaming, the job query is read row by row on stream_conn (the step
+ * and suspend queries for each job go out on the main connection meanwhile)
+ * and the jobs are handed to callback every JOB_CHUNK_SIZE of them.
+ */
+typedef struct {
+	int (*callback)(List job_list, void *arg);
+	void *arg;
+	assoc_mgr_lock_t *locks; /* held by the caller, dropped for callback */
+	mysql_conn_t *stream_conn;
+} job_stream_t;
+
+#define JOB_CHUNK_SIZE 1000
+
 /* if this changes you will need to edit the corresponding
  * enum below also t1 is job_table */
 char *job_req_inx[] = {
@@ -452,13 +466,30 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+/*
+ * Hand a chunk of jobs to the stream callback. The callback sends them to
+ * the client, so don't hold the assoc_mgr locks while a slow client reads.
+ */
+static int _stream_jobs(job_stream_t *stream, List job_list)
+{
+	int rc;
+
+	assoc_mgr_unlock(stream->locks);
+	rc = (stream->callback)(job_list, stream->arg);
+	assoc_mgr_lock(stream->locks);
+	list_flush(job_list);
+
+	return rc;
+}
+
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
 			     char *cluster_name,
 			     char *job_fields, char *step_fields,
 			     char *sent_extra,
-			     bool is_admin, int only_pending, List sent_list)
+			     bool is_admin, int only_pending, List sent_list,
+			     job_stream_t *stream)
 {
 	char *query = NULL;
 	char *extra = xstrdup(sent_extra);
@@ -580,7 +611,11 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	xstrcat(query, " order by id_job, time_submit desc");
 
 	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+	if (stream)
+		result = mysql_db_query_stream(stream->stream_conn, query);
+	else
+		result = mysql_db_query_ret(mysql_conn, query, 0);
+	if (!result) {
 		xfree(query);
 		rc = SLURM_ERROR;
 		goto end_it;
@@ -611,6 +646,20 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 
 		curr_id = slurm_atoul(row[JOB_REQ_JOBID]);
 
+		/*
+		 * Only hand off a chunk between job ids so all the records
+		 * of a job stay together for the duplicate and resize
+		 * handling below.
+		 */
+		if (stream && (curr_id != last_id) &&
+		    (list_count(job_list) >= JOB_CHUNK_SIZE)) {
+			rc = _stream_jobs(stream, job_list);
+			if (rc != SLURM_SUCCESS) {
+				mysql_free_result(result);
+				goto end_it;
+			}
+		}
+
 		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_DUP)
 		    && (curr_id == last_id)
 		    && (slurm_atoul(row[JOB_REQ_STATE]) != JOB_RESIZING))
@@ -746,9 +795,8 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 				if (!(result2 = mysql_db_query_ret(
 					      mysql_conn,
 					      query, 0))) {
-					FREE_NULL_LIST(job_list);
-					job_list = NULL;
 					xfree(query);
+					rc = SLURM_ERROR;
 					break;
 				}
 				xfree(query);
@@ -1105,6 +1153,13 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		/* need to reset here to make the above test valid */
 		step = NULL;
 	}
+	if (stream && (rc == SLURM_SUCCESS) &&
+	    mysql_errno(stream->stream_conn->db_conn)) {
+		error("%s: fetching jobs of cluster %s failed: %s",
+		      __func__, cluster_name,
+		      mysql_error(stream->stream_conn->db_conn));
+		rc = SLURM_ERROR;
+	}
 	mysql_free_result(result);
 
 end_it:
@@ -1113,8 +1168,12 @@ end_it:
 
 	FREE_NULL_LIST(local_cluster_list);
 
-	if (rc == SLURM_SUCCESS)
-		list_transfer(sent_list, job_list);
+	if (rc == SLURM_SUCCESS) {
+		if (!stream)
+			list_transfer(sent_list, job_list);
+		else if (list_count(job_list))
+			rc = _stream_jobs(stream, job_list);
+	}
 
 	FREE_NULL_LIST(job_list);
 	return rc;
@@ -1674,9 +1733,9 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 	return set;
 }
 
-extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
-					      uid_t uid,
-					      slurmdb_job_cond_t *job_cond)
+static List _get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
+		      slurmdb_job_cond_t *job_cond, job_stream_t *stream,
+		      int *rc_out)
 {
 	char *extra = NULL;
 	char *tmp = NULL, *tmp2 = NULL;
@@ -1686,7 +1745,7 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	List job_list = NULL;
 	slurmdb_user_rec_t user;
 	int only_pending = 0;
-	List use_cluster_list = as_mysql_cluster_list;
+	List use_cluster_list = NULL;
 	char *cluster_name;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
@@ -1731,34 +1790,79 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 
 	if (job_cond
 	    && job_cond->cluster_list && list_count(job_cond->cluster_list))
-		use_cluster_list = job_cond->cluster_list;
-	else
+		use_cluster_list = list_shallow_copy(job_cond->cluster_list);
+	else {
+		/*
+		 * Work off a copy so the cluster list isn't locked while a
+		 * stream waits on the client.
+		 */
+		use_cluster_list = list_create(xfree_ptr);
 		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		itr = list_iterator_create(as_mysql_cluster_list);
+		while ((cluster_name = list_next(itr)))
+			list_append(use_cluster_list, xstrdup(cluster_name));
+		list_iterator_destroy(itr);
+		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	}
 
 	assoc_mgr_lock(&locks);
 
-	job_list = list_create(slurmdb_destroy_job_rec);
+	if (stream)
+		stream->locks = &locks;
+	else
+		job_list = list_create(slurmdb_destroy_job_rec);
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		int rc;
 		_setup_job_cond_selected_steps(job_cond, cluster_name, &extra);
 		if ((rc = _cluster_get_jobs(mysql_conn, &user, job_cond,
 					    cluster_name, tmp, tmp2, extra,
-					    is_admin, only_pending, job_list))
-		    != SLURM_SUCCESS)
+					    is_admin, only_pending, job_list,
+					    stream))
+		    != SLURM_SUCCESS) {
 			error("Problem getting jobs for cluster %s",
 			      cluster_name);
+			/* Part of the answer may already be gone, give up */
+			if (stream) {
+				*rc_out = rc;
+				break;
+			}
+		}
 	}
 	list_iterator_destroy(itr);
 
 	assoc_mgr_unlock(&locks);
 
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
-
+	FREE_NULL_LIST(use_cluster_list);
 	xfree(tmp);
 	xfree(tmp2);
 	xfree(extra);
 
 	return job_list;
 }
+
+extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
+					      uid_t uid,
+					      slurmdb_job_cond_t *job_cond)
+{
+	int rc = SLURM_SUCCESS;
+
+	return _get_jobs(mysql_conn, uid, job_cond, NULL, &rc);
+}
+
+extern int as_mysql_jobacct_process_get_jobs_cb(
+	mysql_conn_t *mysql_conn, mysql_conn_t *stream_conn, uid_t uid,
+	slurmdb_job_cond_t *job_cond,
+	int (*callback)(List job_list, void *arg), void *arg)
+{
+	job_stream_t stream = {
+		.callback = callback,
+		.arg = arg,
+		.stream_conn = stream_conn,
+	};
+	int rc = SLURM_SUCCESS;
+
+	(void) _get_jobs(mysql_conn, uid, job_cond, &stream, &rc);
+
+	return rc;
+}
@@ -60,4 +60,14 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
 					   slurmdb_job_cond_t *job_cond);
 
+/*
+ * Same as as_mysql_jobacct_process_get_jobs() but the job query is read
+ * incrementally on stream_conn and the jobs are given to callback in chunks
+ * as they are built.  Anything callback leaves in the List is freed.
+ */
+extern int as_mysql_jobacct_process_get_jobs_cb(
+	mysql_conn_t *mysql_conn, mysql_conn_t *stream_conn, uid_t uid,
+	slurmdb_job_cond_t *job_cond,
+	int (*callback)(List job_list, void *arg), void *arg);
+
 #endif
@@ -42,6 +42,7 @@
 #include "as_mysql_archive.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 
 enum {
 	TIME_ALLOC,
@@ -72,6 +73,29 @@ typedef struct {
 	List loc_tres;
 } local_id_usage_t;
 
+typedef struct {
+	int cnt;
+	time_t *end;
+	uint64_t job_db_inx;
+	time_t *start;
+} local_suspend_t;
+
+/* Phases of the hourly rollup, timed separately */
+enum {
+	ROLLUP_RESV,
+	ROLLUP_CLUSTER,
+	ROLLUP_JOBS,
+	ROLLUP_STORE,
+	ROLLUP_PHASE_CNT
+};
+
+static char *rollup_phase_str[] = {
+	"resv",
+	"cluster",
+	"jobs",
+	"store"
+};
+
 typedef struct {
 	time_t end;
 	int id; /*only needed for reservations */
@@ -109,6 +133,17 @@ static void _destroy_local_id_usage(void *object)
 	}
 }
 
+static void _destroy_local_suspend(void *object)
+{
+	local_suspend_t *suspend = object;
+
+	if (suspend) {
+		xfree(suspend->end);
+		xfree(suspend->start);
+		xfree(suspend);
+	}
+}
+
 static void _destroy_local_cluster_usage(void *object)
 {
 	local_cluster_usage_t *c_usage = (local_cluster_usage_t *)object;
@@ -139,14 +174,43 @@ static int _find_loc_tres(void *x, void *key)
 	return 0;
 }
 
-static int _find_id_usage(void *x, void *key)
+static void _id_usage_identify(void *item, const char **key,
+			       uint32_t *key_len)
 {
-	local_id_usage_t *loc = (local_id_usage_t *)x;
-	uint32_t id = *(uint32_t *)key;
+	local_id_usage_t *usage = item;
 
-	if (loc->id == id)
-		return 1;
-	return 0;
+	*key = (const char *) &usage->id;
+	*key_len = sizeof(usage->id);
+}
+
+static void _suspend_identify(void *item, const char **key, uint32_t *key_len)
+{
+	local_suspend_t *suspend = item;
+
+	*key = (const char *) &suspend->job_db_inx;
+	*key_len = sizeof(suspend->job_db_inx);
+}
+
+/*
+ * Find the usage record of id, adding it if this is the first time it is
+ * seen this hour. The list owns the records and keeps their order, the hash
+ * only makes the lookup cheap with millions of jobs.
+ */
+static local_id_usage_t *_get_id_usage(List usage_list, xhash_t *usage_hash,
+				       int id)
+{
+	local_id_usage_t *usage;
+
+	if ((usage = xhash_get(usage_hash, (char *) &id, sizeof(id))))
+		return usage;
+
+	usage = xmalloc(sizeof(local_id_usage_t));
+	usage->id = id;
+	/* usage->loc_tres is made by the caller when needed */
+	list_append(usage_list, usage);
+	xhash_add(usage_hash, usage);
+
+	return usage;
 }
 
 static void _remove_job_tres_time_from_cluster(List c_tres, List j_tres,
@@ -1211,6 +1275,66 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Load the suspended periods of the jobs in this hour in one query, keyed by
+ * job_db_inx, as the job scan can't run queries while it streams.
+ */
+static int _setup_suspend(mysql_conn_t *mysql_conn, char *cluster_name,
+			  time_t curr_start, time_t curr_end,
+			  xhash_t *suspend_hash)
+{
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	char *query;
+	local_suspend_t *suspend;
+	enum {
+		SUSPEND_REQ_DB_INX,
+		SUSPEND_REQ_START,
+		SUSPEND_REQ_END,
+		SUSPEND_REQ_COUNT
+	};
+
+	query = xstrdup_printf("select suspend.job_db_inx, "
+			       "suspend.time_start, suspend.time_end "
+			       "from \"%s_%s\" as job, \"%s_%s\" as suspend "
+			       "where job.time_suspended && "
+			       "job.time_eligible && job.time_eligible < %ld && "
+			       "(job.time_end >= %ld || job.time_end = 0) && "
+			       "suspend.job_db_inx=job.job_db_inx && "
+			       "suspend.time_start < %ld && "
+			       "(suspend.time_end >= %ld || "
+			       "suspend.time_end = 0)",
+			       cluster_name, job_table,
+			       cluster_name, suspend_table,
+			       curr_end, curr_start, curr_end, curr_start);
+
+	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		uint64_t job_db_inx = slurm_atoull(row[SUSPEND_REQ_DB_INX]);
+
+		if (!(suspend = xhash_get(suspend_hash, (char *) &job_db_inx,
+					  sizeof(job_db_inx)))) {
+			suspend = xmalloc(sizeof(local_suspend_t));
+			suspend->job_db_inx = job_db_inx;
+			xhash_add(suspend_hash, suspend);
+		}
+		xrecalloc(suspend->start, suspend->cnt + 1, sizeof(time_t));
+		xrecalloc(suspend->end, suspend->cnt + 1, sizeof(time_t));
+		suspend->start[suspend->cnt] =
+			slurm_atoul(row[SUSPEND_REQ_START]);
+		suspend->end[suspend->cnt] = slurm_atoul(row[SUSPEND_REQ_END]);
+		suspend->cnt++;
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
 extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				  char *cluster_name,
 				  time_t start, time_t end,
@@ -1233,12 +1357,21 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
+	xhash_t *assoc_usage_hash = xhash_init(_id_usage_identify, NULL);
+	xhash_t *wckey_usage_hash = xhash_init(_id_usage_identify, NULL);
+	xhash_t *suspend_hash = xhash_init(_suspend_identify,
+					   _destroy_local_suspend);
 	uint16_t track_wckey = slurm_get_track_wckey();
 	local_cluster_usage_t *loc_c_usage = NULL;
 	local_cluster_usage_t *c_usage = NULL;
 	local_resv_usage_t *r_usage = NULL;
 	local_id_usage_t *a_usage = NULL;
 	local_id_usage_t *w_usage = NULL;
+	local_suspend_t *suspend = NULL;
+	long phase_usec[ROLLUP_PHASE_CNT] = { 0 };
+	uint32_t job_cnt = 0;
+	char *phase_str = NULL;
+	DEF_TIMERS;
 	/* char start_char[20], end_char[20]; */
 
 	char *job_req_inx[] = {
@@ -1272,29 +1405,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		JOB_REQ_COUNT
 	};
 
-	char *suspend_req_inx[] = {
-		"time_start",
-		"time_end"
-	};
-	char *suspend_str = NULL;
-	enum {
-		SUSPEND_REQ_START,
-		SUSPEND_REQ_END,
-		SUSPEND_REQ_COUNT
-	};
-
 	i=0;
 	xstrfmtcat(job_str, "%s", job_req_inx[i]);
 	for(i=1; i<JOB_REQ_COUNT; i++) {
 		xstrfmtcat(job_str, ", %s", job_req_inx[i]);
 	}
 
-	i=0;
-	xstrfmtcat(suspend_str, "%s", suspend_req_inx[i]);
-	for(i=1; i<SUSPEND_REQ_COUNT; i++) {
-		xstrfmtcat(suspend_str, ", %s", suspend_req_inx[i]);
-	}
-
 	/* We need to figure out the dimensions of this cluster */
 	query = xstrdup_printf("select dimensions from %s where name='%s'",
 			       cluster_table, cluster_name);
@@ -1326,21 +1442,22 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	w_itr = list_iterator_create(wckey_usage_list);
 	r_itr = list_iterator_create(resv_usage_list);
 	while (curr_start < end) {
-		int last_id = -1;
-		int last_wckeyid = -1;
-
 		DB_DEBUG(DB_USAGE, mysql_conn->conn,
 		         "%s curr hour is now %ld-%ld",
 		         cluster_name, curr_start, curr_end);
 /* 		info("start %s", slurm_ctime2(&curr_start)); */
 /* 		info("end %s", slurm_ctime2(&curr_end)); */
 
+		START_TIMER;
 		if ((rc = _setup_resv_usage(mysql_conn, cluster_name,
 					    curr_start, curr_end,
 					    resv_usage_list, dims))
 		    != SLURM_SUCCESS)
 			goto end_it;
+		END_TIMER;
+		phase_usec[ROLLUP_RESV] += DELTA_TIMER;
 
+		START_TIMER;
 		c_usage = _setup_cluster_usage(mysql_conn, cluster_name,
 					       curr_start, curr_end,
 					       resv_usage_list,
@@ -1349,22 +1466,30 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 		if (c_usage)
 			xassert(c_usage->loc_tres);
+		END_TIMER;
+		phase_usec[ROLLUP_CLUSTER] += DELTA_TIMER;
+
+		START_TIMER;
+		if ((rc = _setup_suspend(mysql_conn, cluster_name,
+					 curr_start, curr_end, suspend_hash))
+		    != SLURM_SUCCESS)
+			goto end_it;
 
-		/* now get the jobs during this time only  */
+		/*
+		 * Now get the jobs during this time only. They are aggregated
+		 * as they arrive, so there is no need to have them sorted or
+		 * to hold them all in memory.
+		 */
 		query = xstrdup_printf("select %s from \"%s_%s\" as job "
 				       "where (job.time_eligible && "
 				       "job.time_eligible < %ld && "
 				       "(job.time_end >= %ld || "
-				       "job.time_end = 0)) "
-				       "group by job.job_db_inx "
-				       "order by job.id_assoc, "
-				       "job.time_eligible",
+				       "job.time_end = 0))",
 				       job_str, cluster_name, job_table,
 				       curr_end, curr_start);
 
 		DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
-		if (!(result = mysql_db_query_ret(
-			      mysql_conn, query, 0))) {
+		if (!(result = mysql_db_query_stream(mysql_conn, query))) {
 			rc = SLURM_ERROR;
 			goto end_it;
 		}
@@ -1385,6 +1510,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			int loc_seconds = 0;
 			int seconds = 0, suspend_seconds = 0;
 
+			job_cnt++;
+			a_usage = w_usage = NULL;
+
 			if (row_start && (row_start < curr_start))
 				row_start = curr_start;
 
@@ -1400,36 +1528,18 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			seconds = (row_end - row_start);
 
 			if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
+				uint64_t job_db_inx =
+					slurm_atoull(row[JOB_REQ_DB_INX]);
+
 				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select %s from \"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					suspend_str, cluster_name,
-					suspend_table,
-					curr_end, curr_start,
-					row[JOB_REQ_DB_INX]);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					      mysql_conn,
-					      query, 0))) {
-					rc = SLURM_ERROR;
-					mysql_free_result(result);
-					goto end_it;
-				}
-				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
+				suspend = xhash_get(suspend_hash,
+						    (char *) &job_db_inx,
+						    sizeof(job_db_inx));
+				for (i = 0; suspend && (i < suspend->cnt);
+				     i++) {
 					int tot_time = 0;
-					time_t local_start = slurm_atoul(
-						row2[SUSPEND_REQ_START]);
-					time_t local_end = slurm_atoul(
-						row2[SUSPEND_REQ_END]);
+					time_t local_start = suspend->start[i];
+					time_t local_end = suspend->end[i];
 
 					if (!local_start)
 						continue;
@@ -1443,40 +1553,20 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					if (tot_time > 0)
 						suspend_seconds += tot_time;
 				}
-				mysql_free_result(result2);
 			}
 
-			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
-				last_id = assoc_id;
-				/* a_usage->loc_tres is made later,
-				   don't do it here.
-				*/
-			}
-
-			/* Short circuit this so so we don't get a pointer. */
-			if (!track_wckey)
-				last_wckeyid = wckey_id;
+			/* a_usage->loc_tres is made later, don't do it here. */
+			a_usage = _get_id_usage(assoc_usage_list,
+						assoc_usage_hash, assoc_id);
 
 			/* do the wckey calculation */
-			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
-
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
+			if (track_wckey) {
+				w_usage = _get_id_usage(wckey_usage_list,
+							wckey_usage_hash,
+							wckey_id);
+				if (!w_usage->loc_tres)
 					w_usage->loc_tres = list_create(
 						_destroy_local_tres_usage);
-				}
-				last_wckeyid = wckey_id;
 			}
 
 			/* do the cluster allocated calculation */
@@ -1593,8 +1683,11 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 						     r_usage,
 						     loc_tres,
 						     loc_seconds))
-					    != SLURM_SUCCESS)
+					    != SLURM_SUCCESS) {
+						FREE_NULL_LIST(loc_tres);
+						mysql_free_result(result);
 						goto end_it;
+					}
 				}
 
 				_transfer_loc_tres(&loc_tres, a_usage);
@@ -1673,8 +1766,19 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				}
 			}
 		}
+		if (mysql_errno(mysql_conn->db_conn)) {
+			error("%s: fetching jobs of cluster %s failed: %s",
+			      __func__, cluster_name,
+			      mysql_error(mysql_conn->db_conn));
+			rc = SLURM_ERROR;
+		}
 		mysql_free_result(result);
+		END_TIMER;
+		phase_usec[ROLLUP_JOBS] += DELTA_TIMER;
+		if (rc != SLURM_SUCCESS)
+			goto end_it;
 
+		START_TIMER;
 		/* now figure out how much more to add to the
 		   associations that could had run in the reservation
 		*/
@@ -1721,20 +1825,13 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					r_usage->local_assocs);
 				while ((assoc = list_next(tmp_itr))) {
 					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
-						last_id = associd;
+
+					a_usage = _get_id_usage(
+						assoc_usage_list,
+						assoc_usage_hash, associd);
+					if (!a_usage->loc_tres)
 						a_usage->loc_tres = list_create(
 							_destroy_local_tres_usage);
-					}
 
 					_add_time_tres(a_usage->loc_tres,
 						       TIME_ALLOC, loc_tres->id,
@@ -1816,6 +1913,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		}
 
 	end_loop:
+		END_TIMER;
+		phase_usec[ROLLUP_STORE] += DELTA_TIMER;
+
 		_destroy_local_cluster_usage(c_usage);
 
 		c_usage     = NULL;
@@ -1823,6 +1923,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		a_usage     = NULL;
 		w_usage     = NULL;
 
+		xhash_clear(assoc_usage_hash);
+		xhash_clear(wckey_usage_hash);
+		xhash_clear(suspend_hash);
 		list_flush(assoc_usage_list);
 		list_flush(cluster_down_list);
 		list_flush(wckey_usage_list);
@@ -1832,10 +1935,16 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	}
 end_it:
 	xfree(query);
-	xfree(suspend_str);
 	xfree(job_str);
 	_destroy_local_cluster_usage(c_usage);
 
+	for (i = 0; i < ROLLUP_PHASE_CNT; i++)
+		xstrfmtcat(phase_str, " %s=%ldusec",
+			   rollup_phase_str[i], phase_usec[i]);
+	debug("%s: cluster %s %u job records%s",
+	      __func__, cluster_name, job_cnt, phase_str);
+	xfree(phase_str);
+
 	if (a_itr)
 		list_iterator_destroy(a_itr);
 	if (c_itr)
@@ -1849,6 +1958,9 @@ end_it:
 	FREE_NULL_LIST(cluster_down_list);
 	FREE_NULL_LIST(wckey_usage_list);
 	FREE_NULL_LIST(resv_usage_list);
+	xhash_free(assoc_usage_hash);
+	xhash_free(wckey_usage_hash);
+	xhash_free(suspend_hash);
 
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
@@ -2933,10 +2933,23 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	dbd_cond_msg_t get_msg;
 	dbd_list_msg_t *got_msg;
 	int rc;
-	List my_job_list = NULL;
+	bool stream = false;
+	uint32_t flags = 0;
+	List my_job_list = NULL, part_list = NULL;
 
 	memset(&get_msg, 0, sizeof(dbd_cond_msg_t));
 
+	/*
+	 * The agent only waits for one reply, otherwise let the slurmdbd
+	 * send the jobs as it reads them instead of all at once.
+	 */
+	if (job_cond && db_conn &&
+	    (!running_in_slurmctld() || (db_conn != slurmdbd_conn))) {
+		flags = job_cond->flags;
+		job_cond->flags |= JOBCOND_FLAG_STREAM;
+		stream = true;
+	}
+
 	get_msg.cond = job_cond;
 
 	req.msg_type = DBD_GET_JOBS_COND;
@@ -2944,6 +2957,21 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	req.data = &get_msg;
 	rc = dbd_conn_send_recv(SLURM_PROTOCOL_VERSION, &req, &resp);
 
+	if (stream)
+		job_cond->flags = flags;
+
+	while ((rc == SLURM_SUCCESS) && (resp.msg_type == DBD_GOT_JOBS_PART)) {
+		got_msg = (dbd_list_msg_t *) resp.data;
+		if (!part_list) {
+			part_list = got_msg->my_list;
+			got_msg->my_list = NULL;
+		} else if (got_msg->my_list)
+			list_transfer(part_list, got_msg->my_list);
+		slurmdbd_free_list_msg(got_msg);
+		memset(&resp, 0, sizeof(resp));
+		rc = dbd_conn_recv(SLURM_PROTOCOL_VERSION, db_conn, &resp);
+	}
+
 	if (rc != SLURM_SUCCESS)
 		error("DBD_GET_JOBS_COND failure: %s", slurm_strerror(rc));
 	else if (resp.msg_type == PERSIST_RC) {
@@ -2966,13 +2994,44 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 		if (!my_job_list) {
 			slurm_seterrno(got_msg->return_code);
 			error("%s", slurm_strerror(got_msg->return_code));
+		} else if (part_list) {
+			list_transfer(part_list, my_job_list);
+			FREE_NULL_LIST(my_job_list);
+			my_job_list = part_list;
+			part_list = NULL;
 		}
 		slurmdbd_free_list_msg(got_msg);
 	}
 
+	/* Only part of the answer made it */
+	FREE_NULL_LIST(part_list);
+
 	return my_job_list;
 }
 
+/*
+ * get info from the storage a chunk at a time, the dbd hands back the whole
+ * List so it is given to the callback at once
+ */
+extern int jobacct_storage_p_get_jobs_cond_cb(void *db_conn, uid_t uid,
+					      slurmdb_job_cond_t *job_cond,
+					      int (*callback)(List job_list,
+							      void *arg),
+					      void *arg)
+{
+	List job_list;
+	int rc;
+
+	if (!(job_list = jobacct_storage_p_get_jobs_cond(db_conn, uid,
+							 job_cond)))
+		return errno ? errno : SLURM_ERROR;
+
+	rc = (*callback)(job_list, arg);
+	FREE_NULL_LIST(job_list);
+
+	return rc;
+}
+
 /*
  * Expire old info from the storage
  * Not applicable for any database
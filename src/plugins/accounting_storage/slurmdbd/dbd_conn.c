@@ -306,6 +306,33 @@ end_it:
 	return rc;
 }
 
+extern int dbd_conn_recv(uint16_t rpc_version, slurm_persist_conn_t *pc,
+			 persist_msg_t *resp)
+{
+	int rc;
+	buf_t *buffer;
+
+	xassert(pc);
+	xassert(resp);
+
+	if (!(buffer = slurm_persist_recv_msg(pc))) {
+		error("Getting continued response from slurmdbd");
+		rc = SLURM_ERROR;
+	} else {
+		rc = unpack_slurmdbd_msg(resp, rpc_version, buffer);
+		free_buf(buffer);
+	}
+
+	/*
+	 * Whatever is left of the reply would be taken as the answer to the
+	 * next RPC, start over on a new connection instead.
+	 */
+	if (rc != SLURM_SUCCESS)
+		slurm_persist_conn_close(pc);
+
+	return rc;
+}
+
 extern int dbd_conn_send_recv_rc_msg(uint16_t rpc_version,
 				     persist_msg_t *req,
 				     int *resp_code)
@@ -37,6 +37,9 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
+#include <dirent.h>
+#include <inttypes.h>
+
 #include "src/common/slurm_xlator.h"
 
 #include "src/common/fd.h"
@@ -55,6 +58,9 @@ slurm_persist_conn_t *slurmdbd_conn = NULL;
 
 
 #define DBD_MAGIC		0xDEAD3219
+#define DBD_SPILL_BATCH		2000	/* max records moved to memory per pass */
+#define DBD_SPILL_PREFIX	"dbd.spill."
+#define DBD_SPILL_SEG_SIZE	(16 * 1024 * 1024)
 #define DEBUG_PRINT_MAX_MSG_TYPES 10
 #define MAX_DBD_DEFAULT_ACTION MAX_DBD_ACTION_DISCARD
 
@@ -71,6 +77,29 @@ static pthread_cond_t  slurmdbd_cond = PTHREAD_COND_INITIALIZER;
 
 static int max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
 
+/*
+ * Spill queue: once agent_list holds MaxDBDMsgs messages and
+ * max_dbd_spill_size is configured, new messages are appended to segment
+ * files in StateSaveLocation instead. The agent moves them back into
+ * agent_list as it drains. Segments spill_rd_seq through spill_wr_seq exist
+ * while spill_active is set. All of this is protected by agent_lock. Disk
+ * reads and fsync() are done by the agent thread with agent_lock released, as
+ * slurmctld threads holding job locks queue messages under it.
+ */
+static uint64_t  spill_quota      = 0;	/* bytes, 0 if spilling disabled */
+static bool      spill_active     = false;
+static uint64_t  spill_bytes      = 0;	/* bytes queued in segments */
+static uint32_t  spill_msgs       = 0;	/* messages queued in segments */
+static uint32_t  spill_rd_seq     = 0;	/* segment being consumed */
+static int       spill_rd_fd      = -1;
+static uint16_t  spill_rd_version = 0;	/* protocol of spill_rd_seq records */
+static uint32_t  spill_wr_seq     = 0;	/* segment being appended to */
+static int       spill_wr_fd      = -1;
+static uint32_t  spill_wr_size    = 0;	/* bytes in spill_wr_seq */
+static bool      spill_reading    = false; /* agent reading spill_rd_fd */
+static int      *spill_sync_fds   = NULL; /* finished segments to fsync */
+static int       spill_sync_cnt   = 0;
+
 static int _unpack_return_code(uint16_t rpc_version, buf_t *buffer)
 {
 	uint16_t msg_type = -1;
@@ -292,6 +321,64 @@ static buf_t *_load_dbd_rec(int fd)
 	return buffer;
 }
 
+/* Read the "VER%d" header record of a state file, RET 0 if not found */
+static uint16_t _load_dbd_ver(int fd)
+{
+	char *ver_str = NULL;
+	uint32_t ver_str_len;
+	uint16_t rpc_version = 0;
+	buf_t *buffer;
+
+	if (!(buffer = _load_dbd_rec(fd)))
+		return 0;
+	/* This is set to the end of the buffer for send so we
+	   need to set it back to 0 */
+	set_buf_offset(buffer, 0);
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	debug3("Version string in dbd_state header is %s", ver_str);
+unpack_error:
+	free_buf(buffer);
+	if (ver_str) {
+		/* get the version after VER */
+		rpc_version = slurm_atoul(ver_str + 3);
+		xfree(ver_str);
+	}
+	return rpc_version;
+}
+
+/*
+ * Repack a record saved by an older Slurm version with the current
+ * protocol version. RET the buffer to queue or NULL on error
+ */
+static buf_t *_convert_dbd_rec(buf_t *buffer, uint16_t rpc_version)
+{
+	persist_msg_t msg = {0};
+	int rc;
+
+	if (rpc_version == SLURM_PROTOCOL_VERSION)
+		return buffer;
+
+	set_buf_offset(buffer, 0);
+	rc = unpack_slurmdbd_msg(&msg, rpc_version, buffer);
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS)
+		return NULL;
+	return pack_slurmdbd_msg(&msg, SLURM_PROTOCOL_VERSION);
+}
+
+/* Get the message type of a packed record, RET SLURM_ERROR if too short */
+static int _get_rec_type(buf_t *buffer, uint16_t *msg_type)
+{
+	uint32_t offset = get_buf_offset(buffer);
+
+	if (offset < 2)
+		return SLURM_ERROR;
+	set_buf_offset(buffer, 0);
+	(void) unpack16(msg_type, buffer);	/* checked by offset */
+	set_buf_offset(buffer, offset);
+	return SLURM_SUCCESS;
+}
+
 static void _load_dbd_state(void)
 {
 	char *dbd_fname = NULL;
@@ -310,63 +397,20 @@ static void _load_dbd_state(void)
 			error("Opening state save file %s: %m",
 			      dbd_fname);
 	} else {
-		char *ver_str = NULL;
-		uint32_t ver_str_len;
-
-		buffer = _load_dbd_rec(fd);
-		if (buffer == NULL)
-			goto end_it;
-		/* This is set to the end of the buffer for send so we
-		   need to set it back to 0 */
-		set_buf_offset(buffer, 0);
-		safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
-		debug3("Version string in dbd_state header is %s", ver_str);
-	unpack_error:
-		free_buf(buffer);
-		buffer = NULL;
-		if (ver_str) {
-			/* get the version after VER */
-			rpc_version = slurm_atoul(ver_str + 3);
-			xfree(ver_str);
-		}
+		rpc_version = _load_dbd_ver(fd);
 
-		while (1) {
-			/* If the buffer was not the VER%d string it
-			   was an actual message so we don't want to
-			   skip it.
-			*/
-			if (!buffer)
-				buffer = _load_dbd_rec(fd);
-			if (buffer == NULL)
-				break;
-			if (rpc_version != SLURM_PROTOCOL_VERSION) {
-				/* unpack and repack with new
-				 * PROTOCOL_VERSION just so we keep
-				 * things up to date.
-				 */
-				persist_msg_t msg = {0};
-				int rc;
-				set_buf_offset(buffer, 0);
-				rc = unpack_slurmdbd_msg(
-					&msg, rpc_version, buffer);
-				free_buf(buffer);
-				if (rc == SLURM_SUCCESS)
-					buffer = pack_slurmdbd_msg(
-						&msg, SLURM_PROTOCOL_VERSION);
-				else
-					buffer = NULL;
-			}
-			if (!buffer) {
+		while ((buffer = _load_dbd_rec(fd))) {
+			/* unpack and repack with new PROTOCOL_VERSION
+			 * just so we keep things up to date. */
+			if (!(buffer = _convert_dbd_rec(buffer, rpc_version))) {
 				error("no buffer given");
 				continue;
 			}
 			if (!list_enqueue(agent_list, buffer))
 				fatal("list_enqueue, no memory");
 			recovered++;
-			buffer = NULL;
 		}
 
-	end_it:
 		verbose("recovered %d pending RPCs", recovered);
 		(void) close(fd);
 	}
@@ -411,46 +455,344 @@ static int _save_dbd_rec(int fd, buf_t *buffer)
 	return SLURM_SUCCESS;
 }
 
+/* Write the "VER%d" header record of a state file */
+static int _save_dbd_ver(int fd)
+{
+	char curr_ver_str[10];
+	buf_t *buffer;
+	int rc;
+
+	snprintf(curr_ver_str, sizeof(curr_ver_str),
+		 "VER%d", SLURM_PROTOCOL_VERSION);
+	buffer = init_buf(strlen(curr_ver_str));
+	packstr(curr_ver_str, buffer);
+	rc = _save_dbd_rec(fd, buffer);
+	free_buf(buffer);
+
+	return rc;
+}
+
+static char *_spill_fname(uint32_t seq)
+{
+	return xstrdup_printf("%s/" DBD_SPILL_PREFIX "%u",
+			      slurm_conf.state_save_location, seq);
+}
+
+/* Stop appending to spill_wr_seq, the agent thread fsyncs it later */
+static void _spill_seal_wr(void)
+{
+	if (spill_wr_fd < 0)
+		return;
+
+	xrecalloc(spill_sync_fds, spill_sync_cnt + 1, sizeof(int));
+	spill_sync_fds[spill_sync_cnt++] = spill_wr_fd;
+	spill_wr_fd = -1;
+}
+
+/* fsync and close the sealed segments, call with agent_lock released */
+static void _spill_sync(void)
+{
+	int *fds, cnt, i;
+
+	slurm_mutex_lock(&agent_lock);
+	fds = spill_sync_fds;
+	cnt = spill_sync_cnt;
+	spill_sync_fds = NULL;
+	spill_sync_cnt = 0;
+	slurm_mutex_unlock(&agent_lock);
+
+	for (i = 0; i < cnt; i++)
+		(void) fsync_and_close(fds[i], DBD_SPILL_PREFIX);
+	xfree(fds);
+}
+
+/* Remove the segment being consumed and move on to the next one */
+static void _spill_next_seg(void)
+{
+	char *fname = _spill_fname(spill_rd_seq);
+
+	if (spill_rd_fd >= 0) {
+		(void) close(spill_rd_fd);
+		spill_rd_fd = -1;
+	}
+	(void) unlink(fname);
+	xfree(fname);
+
+	if (spill_rd_seq != spill_wr_seq) {
+		spill_rd_seq++;
+		return;
+	}
+
+	/* Caught up with the writer, the spill queue is empty */
+	if (spill_wr_fd >= 0) {
+		(void) close(spill_wr_fd);
+		spill_wr_fd = -1;
+	}
+	spill_active = false;
+	spill_bytes = 0;
+	spill_msgs = 0;
+}
+
+/* Open the segment being consumed, RET SLURM_ERROR if it is unreadable */
+static int _spill_open_rd(void)
+{
+	char *fname;
+
+	if (spill_rd_fd >= 0)
+		return SLURM_SUCCESS;
+
+	fname = _spill_fname(spill_rd_seq);
+	spill_rd_fd = open(fname, O_RDONLY);
+	if (spill_rd_fd < 0) {
+		error("Opening spill file %s: %m", fname);
+		xfree(fname);
+		return SLURM_ERROR;
+	}
+	xfree(fname);
+	spill_rd_version = _load_dbd_ver(spill_rd_fd);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Read the next record of the segment being consumed
+ * RET the record, converted to SLURM_PROTOCOL_VERSION, or NULL at the end of
+ *     the segment
+ */
+static buf_t *_spill_read_rec(void)
+{
+	buf_t *buffer;
+	uint32_t size;
+
+	while (spill_active && (_spill_open_rd() == SLURM_SUCCESS)) {
+		if (!(buffer = _load_dbd_rec(spill_rd_fd))) {
+			_spill_next_seg();
+			break;
+		}
+
+		size = get_buf_offset(buffer) + (2 * sizeof(uint32_t));
+		spill_bytes -= MIN(spill_bytes, size);
+		if (spill_msgs)
+			spill_msgs--;
+
+		if ((buffer = _convert_dbd_rec(buffer, spill_rd_version)))
+			return buffer;
+		error("unable to convert spilled %s record",
+		      DBD_SPILL_PREFIX);
+	}
+
+	return NULL;
+}
+
+/*
+ * Move up to max_cnt spilled records to the end of agent_list. Called by the
+ * agent thread with agent_lock held, the lock is released while reading.
+ */
+static void _spill_refill(uint32_t max_cnt)
+{
+	List recs;
+	buf_t *buffer;
+	uint32_t cnt = 0, msgs;
+	uint64_t bytes;
+	uint16_t rpc_version;
+	int fd;
+	bool seg_end;
+
+	while (spill_active && (cnt < max_cnt)) {
+		/* The writer must not append to a segment being read */
+		if (spill_rd_seq == spill_wr_seq)
+			_spill_seal_wr();
+		if (_spill_open_rd() != SLURM_SUCCESS) {
+			_spill_next_seg();
+			continue;
+		}
+
+		/*
+		 * Only this thread touches spill_rd_fd and spill_rd_seq while
+		 * spill_active is set. Messages queued meanwhile go to later
+		 * segments, so the order is kept.
+		 */
+		fd = spill_rd_fd;
+		rpc_version = spill_rd_version;
+		spill_reading = true;
+		slurm_mutex_unlock(&agent_lock);
+
+		recs = list_create(slurmdbd_free_buffer);
+		bytes = 0;
+		msgs = 0;
+		seg_end = false;
+		while (cnt < max_cnt) {
+			/* The segment is sealed, so EOF means done */
+			if (!(buffer = _load_dbd_rec(fd))) {
+				seg_end = true;
+				break;
+			}
+			bytes += get_buf_offset(buffer) + (2 * sizeof(uint32_t));
+			msgs++;
+			if (!(buffer = _convert_dbd_rec(buffer, rpc_version))) {
+				error("unable to convert spilled %s record",
+				      DBD_SPILL_PREFIX);
+				continue;
+			}
+			list_enqueue(recs, buffer);
+			cnt++;
+		}
+
+		slurm_mutex_lock(&agent_lock);
+		spill_reading = false;
+		list_transfer(agent_list, recs);
+		FREE_NULL_LIST(recs);
+		spill_bytes -= MIN(spill_bytes, bytes);
+		spill_msgs -= MIN(spill_msgs, msgs);
+		if (seg_end)
+			_spill_next_seg();
+	}
+
+	log_flag(AGENT, "slurmdbd agent moved %u messages from spill files, %u left",
+		 cnt, spill_msgs);
+}
+
+/* Append a record to the spill segments */
+static int _spill_write(buf_t *buffer)
+{
+	char *fname;
+	uint32_t size;
+
+	if (spill_wr_size >= DBD_SPILL_SEG_SIZE)
+		_spill_seal_wr();
+
+	if (spill_wr_fd < 0) {
+		if (spill_active)
+			spill_wr_seq++;
+		else
+			spill_rd_seq = ++spill_wr_seq;
+		spill_active = true;
+		spill_wr_size = 0;
+
+		fname = _spill_fname(spill_wr_seq);
+		spill_wr_fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+		if (spill_wr_fd < 0) {
+			error("Creating spill file %s: %m", fname);
+			xfree(fname);
+			return SLURM_ERROR;
+		}
+		xfree(fname);
+		if (_save_dbd_ver(spill_wr_fd) != SLURM_SUCCESS)
+			goto fail;
+	}
+
+	if (_save_dbd_rec(spill_wr_fd, buffer) != SLURM_SUCCESS)
+		goto fail;
+
+	size = get_buf_offset(buffer) + (2 * sizeof(uint32_t));
+	spill_wr_size += size;
+	spill_bytes += size;
+	spill_msgs++;
+
+	return SLURM_SUCCESS;
+
+fail:
+	/* Never append after a partial record, start a new segment */
+	(void) close(spill_wr_fd);
+	spill_wr_fd = -1;
+	return SLURM_ERROR;
+}
+
+/* Find the spill segments left by a previous slurmctld */
+static void _spill_recover(void)
+{
+	DIR *dir;
+	struct dirent *ent;
+	char *end;
+	uint32_t seq, min_seq = UINT32_MAX, max_seq = 0;
+	buf_t *buffer;
+	int fd;
+
+	spill_active = false;
+	spill_bytes = 0;
+	spill_msgs = 0;
+	spill_rd_fd = -1;
+	spill_wr_fd = -1;
+
+	if (!(dir = opendir(slurm_conf.state_save_location))) {
+		error("%s: opendir(%s): %m",
+		      __func__, slurm_conf.state_save_location);
+		return;
+	}
+	while ((ent = readdir(dir))) {
+		if (xstrncmp(ent->d_name, DBD_SPILL_PREFIX,
+			     strlen(DBD_SPILL_PREFIX)))
+			continue;
+		seq = strtoul(ent->d_name + strlen(DBD_SPILL_PREFIX), &end, 10);
+		if (end[0] != '\0')
+			continue;
+		min_seq = MIN(min_seq, seq);
+		max_seq = MAX(max_seq, seq);
+		spill_active = true;
+	}
+	closedir(dir);
+
+	if (!spill_active)
+		return;
+
+	spill_rd_seq = min_seq;
+	spill_wr_seq = max_seq;
+	for (seq = min_seq; seq <= max_seq; seq++) {
+		char *fname = _spill_fname(seq);
+
+		if ((fd = open(fname, O_RDONLY)) >= 0) {
+			(void) _load_dbd_ver(fd);
+			while ((buffer = _load_dbd_rec(fd))) {
+				spill_bytes += get_buf_offset(buffer) +
+					       (2 * sizeof(uint32_t));
+				spill_msgs++;
+				free_buf(buffer);
+			}
+			(void) close(fd);
+		}
+		xfree(fname);
+	}
+
+	verbose("recovered %u pending RPCs from %u spill files",
+		spill_msgs, (max_seq - min_seq + 1));
+}
+
 static void _save_dbd_state(void)
 {
 	char *dbd_fname = NULL;
 	buf_t *buffer;
 	int fd, rc, wrote = 0;
 	uint16_t msg_type;
-	uint32_t offset;
 
 	xstrfmtcat(dbd_fname, "%s/dbd.messages", slurm_conf.state_save_location);
 	(void) unlink(dbd_fname);	/* clear save state */
 	fd = open(dbd_fname, O_WRONLY | O_CREAT | O_TRUNC, 0600);
 	if (fd < 0) {
 		error("Creating state save file %s", dbd_fname);
-	} else if (list_count(agent_list)) {
-		char curr_ver_str[10];
-		snprintf(curr_ver_str, sizeof(curr_ver_str),
-			 "VER%d", SLURM_PROTOCOL_VERSION);
-		buffer = init_buf(strlen(curr_ver_str));
-		packstr(curr_ver_str, buffer);
-		rc = _save_dbd_rec(fd, buffer);
-		free_buf(buffer);
-		if (rc != SLURM_SUCCESS)
+	} else if (list_count(agent_list) ||
+		   ((spill_rd_fd >= 0) && !spill_reading)) {
+		if (_save_dbd_ver(fd) != SLURM_SUCCESS)
 			goto end_it;
 
-		while ((buffer = list_dequeue(agent_list))) {
+		/*
+		 * The rest of a partially consumed spill file goes after the
+		 * queued messages, dbd.messages is loaded before the spill
+		 * files on startup. If the agent is reading it right now (fatal
+		 * from another thread) the whole segment is left for
+		 * _spill_recover(), resending some messages.
+		 */
+		while ((buffer = list_dequeue(agent_list)) ||
+		       ((spill_rd_fd >= 0) && !spill_reading &&
+			(buffer = _spill_read_rec()))) {
 			/*
 			 * We do not want to store registration messages. If an
 			 * admin puts in an incorrect cluster name we can get a
 			 * deadlock unless they add the bogus cluster name to
 			 * the accounting system.
 			 */
-			offset = get_buf_offset(buffer);
-			if (offset < 2) {
-				free_buf(buffer);
-				continue;
-			}
-			set_buf_offset(buffer, 0);
-			(void) unpack16(&msg_type, buffer);  /* checked by offset */
-			set_buf_offset(buffer, offset);
-			if (msg_type == DBD_REGISTER_CTLD) {
+			if ((_get_rec_type(buffer, &msg_type) !=
+			     SLURM_SUCCESS) ||
+			    (msg_type == DBD_REGISTER_CTLD)) {
 				free_buf(buffer);
 				continue;
 			}
@@ -463,6 +805,13 @@ static void _save_dbd_state(void)
 		}
 	}
 
+	/* Remaining spill files are picked up again by _spill_recover() */
+	_spill_seal_wr();
+	for (int i = 0; i < spill_sync_cnt; i++)
+		(void) fsync_and_close(spill_sync_fds[i], DBD_SPILL_PREFIX);
+	xfree(spill_sync_fds);
+	spill_sync_cnt = 0;
+
 end_it:
 	if (fd >= 0) {
 		verbose("saved %d pending RPCs", wrote);
@@ -532,6 +881,10 @@ static int _purge_job_start_req(void)
 
 static void _max_dbd_msg_action(uint32_t *msg_cnt)
 {
+	/* MaxDBDMsgs only caps memory, _spill_enqueue() handles full disks */
+	if (spill_quota)
+		return;
+
 	if (max_dbd_msg_action == MAX_DBD_ACTION_EXIT) {
 		if (*msg_cnt < slurm_conf.max_dbd_msgs)
 			return;
@@ -548,6 +901,53 @@ static void _max_dbd_msg_action(uint32_t *msg_cnt)
 		*msg_cnt -= _purge_job_start_req();
 }
 
+/*
+ * Queue a message in the spill files. Once anything has been spilled all
+ * new messages go there until the agent has drained them, so the SlurmDBD
+ * still gets the messages in the order they were generated.
+ */
+static int _spill_enqueue(buf_t *buffer, persist_msg_t *req)
+{
+	static time_t syslog_time = 0;
+	uint32_t size = get_buf_offset(buffer) + (2 * sizeof(uint32_t));
+
+	if (spill_quota && (spill_bytes >= (spill_quota / 2)) &&
+	    (difftime(time(NULL), syslog_time) > 120)) {
+		/* Record critical error every 120 seconds */
+		syslog_time = time(NULL);
+		error("agent spill files filling (%"PRIu64" of %"PRIu64" bytes), RESTART SLURMDBD NOW",
+		      spill_bytes, spill_quota);
+		syslog(LOG_CRIT, "*** RESTART SLURMDBD NOW ***");
+		(slurmdbd_conn->trigger_callbacks.dbd_fail)();
+	}
+
+	/*
+	 * With spilling disabled, by reconfigure or segments left from before
+	 * a restart, new messages still go after the old ones to keep the
+	 * order. MaxDBDMsgs then bounds the whole queue, as it would in memory.
+	 */
+	if ((spill_quota ? ((spill_bytes + size) <= spill_quota) :
+	     ((list_count(agent_list) + spill_msgs) <
+	      slurm_conf.max_dbd_msgs)) &&
+	    (_spill_write(buffer) == SLURM_SUCCESS)) {
+		free_buf(buffer);
+		return SLURM_SUCCESS;
+	}
+
+	if (max_dbd_msg_action == MAX_DBD_ACTION_EXIT) {
+		_save_dbd_state();
+		fatal("agent spill files are full (%u), not continuing until slurmdbd is able to process messages.",
+		      spill_msgs);
+	}
+
+	error("agent spill files are full (%u), discarding %s:%u request",
+	      spill_msgs, slurmdbd_msg_type_2_str(req->msg_type, 1),
+	      req->msg_type);
+	(slurmdbd_conn->trigger_callbacks.acct_full)();
+	free_buf(buffer);
+	return SLURM_ERROR;
+}
+
 static void _sig_handler(int signal)
 {
 }
@@ -625,6 +1025,8 @@ static void *_agent(void *x)
 		 slurmdbd_msg_type_2_str(list_req.msg_type, 1));
 
 	while (*slurmdbd_conn->shutdown == 0) {
+		_spill_sync();
+
 		slurm_mutex_lock(&slurmdbd_lock);
 		if (halt_agent) {
 			log_flag(AGENT, "slurmdbd agent halt with agent_count=%d",
@@ -648,6 +1050,11 @@ static void *_agent(void *x)
 
 		slurm_mutex_lock(&agent_lock);
 		cnt = list_count(agent_list);
+		if (spill_active && (cnt < (slurm_conf.max_dbd_msgs / 2))) {
+			_spill_refill(MIN(DBD_SPILL_BATCH,
+					  slurm_conf.max_dbd_msgs - cnt));
+			cnt = list_count(agent_list);
+		}
 		if ((cnt == 0) || (slurmdbd_conn->fd < 0) ||
 		    (fail_time && (difftime(time(NULL), fail_time) < 10))) {
 			slurm_mutex_unlock(&slurmdbd_lock);
@@ -794,6 +1201,7 @@ static void _create_agent(void)
 	if (agent_list == NULL) {
 		agent_list = list_create(slurmdbd_free_buffer);
 		_load_dbd_state();
+		_spill_recover();
 	}
 
 	if (agent_tid == 0) {
@@ -932,7 +1340,14 @@ extern int slurmdbd_agent_send(uint16_t rpc_version, persist_msg_t *req)
 		}
 	}
 	cnt = list_count(agent_list);
-	if ((cnt >= (slurm_conf.max_dbd_msgs / 2)) &&
+	if (spill_active ||
+	    (spill_quota && (cnt >= slurm_conf.max_dbd_msgs))) {
+		rc = _spill_enqueue(buffer, req);
+		slurm_cond_broadcast(&agent_cond);
+		slurm_mutex_unlock(&agent_lock);
+		return rc;
+	}
+	if (!spill_quota && (cnt >= (slurm_conf.max_dbd_msgs / 2)) &&
 	    (difftime(time(NULL), syslog_time) > 120)) {
 		/* Record critical error every 120 seconds */
 		syslog_time = time(NULL);
@@ -974,7 +1389,7 @@ extern bool slurmdbd_conn_active(void)
 
 extern int slurmdbd_agent_queue_count(void)
 {
-	return list_count(agent_list);
+	return list_count(agent_list) + spill_msgs;
 }
 
 extern void slurmdbd_agent_config_setup(void)
@@ -1007,4 +1422,14 @@ extern void slurmdbd_agent_config_setup(void)
 		xfree(type);
 	} else
 		max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
+
+	/*                          012345678901234567890 */
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+	                           "max_dbd_spill_size="))) {
+		spill_quota = strtoull(tmp_ptr + 19, NULL, 10) * 1024 * 1024;
+		if (!spill_quota)
+			fatal("Invalid SlurmctldParameters option max_dbd_spill_size='%s'",
+			      tmp_ptr + 19);
+	} else
+		spill_quota = 0;
 }
@@ -186,6 +186,8 @@ static int _job_rec_field_index(lua_State *L)
 	lua_getmetatable(L, -2);
 	lua_getfield(L, -1, "_job_rec_ptr");
 	job_ptr = lua_touserdata(L, -1);
+	if (job_ptr && !xstrcmp(name, "argv"))
+		load_job_details_argv(job_ptr->details);
 
 	return slurm_lua_job_record_field(L, job_ptr, name);
 }
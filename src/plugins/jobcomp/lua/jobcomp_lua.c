@@ -121,6 +121,8 @@ static int _job_rec_field_index(lua_State *st)
 	lua_getmetatable(st, -2);
 	lua_getfield(st, -1, "_job_rec_ptr");
 	job_ptr = lua_touserdata(st, -1);
+	if (job_ptr && !xstrcmp(name, "argv"))
+		load_job_details_argv(job_ptr->details);
 
 	return slurm_lua_job_record_field(st, job_ptr, name);
 }
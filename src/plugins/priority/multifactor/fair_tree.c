@@ -42,11 +42,85 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "src/common/xhash.h"
+
 #include "fair_tree.h"
 
+/*
+ * Per-account state kept between passes so that accounts whose subtree did
+ * not change can reuse their previous ranking instead of being re-sorted.
+ * A subtree's ranking depends only on the order of the level_fs values
+ * beneath it (including which neighbors are tied) and on the rank state it
+ * is entered with, so both are recorded here. Comparing the order rather
+ * than the values keeps the uniform usage decay from dirtying every account.
+ */
+typedef struct {
+	uint32_t id;		/* association id, hash key */
+	void *usage;		/* assoc->usage when last seen */
+	uint64_t child_sig;	/* hash of the children when last seen */
+	slurmdb_assoc_rec_t **sorted; /* children in last ranked order */
+	bool *tied;		/* tied[i]: sorted[i] ties sorted[i - 1] */
+	uint32_t sorted_cnt;
+	bool dirty;		/* an order beneath this account changed */
+	bool valid;		/* the fields below describe the last ranking */
+	bool tied_in;
+	uint32_t rank_in;
+	uint32_t rnt_in;
+	uint32_t rank_out;
+	uint32_t rnt_out;
+} ft_cache_t;
+
+static xhash_t *ft_cache = NULL;
+static slurmdb_assoc_rec_t *ft_cache_root = NULL;
+static uint32_t ft_cache_users = 0;
+static uint32_t ft_reset_gen = 1, ft_cache_gen = 0;
+static uint32_t ft_ranked_cnt = 0, ft_reused_cnt = 0;
+
 static int  _ft_decay_apply_new_usage(job_record_t *job, time_t *start);
 static void _apply_priority_fs(void);
 
+static void _ft_cache_id(void *item, const char **key, uint32_t *key_len)
+{
+	ft_cache_t *cache = item;
+
+	*key = (const char *) &cache->id;
+	*key_len = sizeof(cache->id);
+}
+
+static void _ft_cache_free(void *item)
+{
+	ft_cache_t *cache = item;
+
+	xfree(cache->sorted);
+	xfree(cache->tied);
+	xfree(cache);
+}
+
+static ft_cache_t *_ft_cache_get(slurmdb_assoc_rec_t *assoc)
+{
+	ft_cache_t *cache;
+
+	if (!(cache = xhash_get(ft_cache, (const char *) &assoc->id,
+				sizeof(assoc->id)))) {
+		cache = xmalloc(sizeof(*cache));
+		cache->id = assoc->id;
+		xhash_add(ft_cache, cache);
+	}
+	return cache;
+}
+
+extern void fair_tree_reset(void)
+{
+	ft_reset_gen++;
+}
+
+extern void fair_tree_fini(void)
+{
+	if (ft_cache)
+		xhash_free(ft_cache);
+	ft_cache_root = NULL;
+}
+
 /* Fair Tree code called from the decay thread loop */
 extern void fair_tree_decay(List jobs, time_t start)
 {
@@ -68,7 +142,7 @@ extern void fair_tree_decay(List jobs, time_t start)
 
 	/* assign job priorities */
 	lock_slurmctld(job_write_lock);
-	list_for_each(jobs, (ListForF) decay_apply_weighted_factors, &start);
+	decay_apply_weighted_factors_list(jobs, start);
 	unlock_slurmctld(job_write_lock);
 }
 
@@ -304,6 +378,44 @@ static slurmdb_assoc_rec_t** _merge_accounts(
 }
 
 
+/* Remember the order in which an account's children were ranked */
+static void _ft_cache_set_order(ft_cache_t *cache,
+				slurmdb_assoc_rec_t **sorted, uint32_t cnt)
+{
+	if (cache->sorted_cnt != cnt) {
+		xfree(cache->sorted);
+		xfree(cache->tied);
+		cache->sorted = xcalloc(cnt + 1, sizeof(*cache->sorted));
+		cache->tied = xcalloc(cnt + 1, sizeof(*cache->tied));
+		cache->sorted_cnt = cnt;
+	}
+	for (uint32_t i = 0; i < cnt; i++) {
+		cache->sorted[i] = sorted[i];
+		cache->tied[i] = i && (sorted[i - 1]->usage->level_fs ==
+				       sorted[i]->usage->level_fs);
+	}
+}
+
+/* RET true if the current level_fs values would rank the children in a
+ * different order or with different ties than last time */
+static bool _ft_order_changed(ft_cache_t *cache)
+{
+	if (!cache->sorted)
+		return true;
+
+	for (uint32_t i = 1; i < cache->sorted_cnt; i++) {
+		slurmdb_assoc_rec_t *prev = cache->sorted[i - 1];
+		slurmdb_assoc_rec_t *assoc = cache->sorted[i];
+
+		if (_cmp_level_fs(&prev, &assoc) > 0)
+			return true;
+		if ((prev->usage->level_fs == assoc->usage->level_fs) !=
+		    cache->tied[i])
+			return true;
+	}
+	return false;
+}
+
 /* Calculate fairshare for each child then sort children by fairshare value
  * (level_fs). Once they are sorted, operate on each child in sorted order.
  * This portion of the tree is now sorted and users are given a fairshare value
@@ -323,10 +435,13 @@ static slurmdb_assoc_rec_t** _merge_accounts(
  * IN/OUT rank - current user ranking, starting at g_user_assoc_count
  * IN/OUT rnt - rank, no ties (what rank would be if no tie exists)
  * IN account_tied - is this account tied with the previous user
+ * IN level_cache - cache entry of the account owning siblings, NULL if the
+ *		    array merges the children of tied accounts
  */
 static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 			  uint16_t assoc_level, uint32_t *rank,
-			  uint32_t *rnt, bool account_tied)
+			  uint32_t *rnt, bool account_tied,
+			  ft_cache_t *level_cache)
 {
 	slurmdb_assoc_rec_t *assoc = NULL;
 	long double prev_level_fs = (long double) NO_VAL;
@@ -339,12 +454,14 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 		return;
 	}
 
-	/* Calculate level_fs for each child */
-	for (i = 0; (assoc = siblings[i]); i++)
-		_calc_assoc_fs(assoc);
+	/* level_fs of each child was set by _ft_refresh_children() */
+	for (i = 0; siblings[i]; i++)
+		;
 
 	/* Sort children by level_fs */
 	qsort(siblings, i, sizeof(slurmdb_assoc_rec_t *), _cmp_level_fs);
+	if (level_cache)
+		_ft_cache_set_order(level_cache, siblings, i);
 
 	/* Iterate through children in sorted order. If it's a user, calculate
 	 * fs_factor, otherwise recurse. */
@@ -376,6 +493,23 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 		} else {
 			slurmdb_assoc_rec_t** children;
 			size_t merge_count = _count_tied_accounts(siblings, i);
+			ft_cache_t *cache = _ft_cache_get(assoc);
+
+			/* An unchanged subtree entered the same way as last
+			 * time ranks its users the same way, so skip it */
+			if (!merge_count && cache->valid && !cache->dirty &&
+			    (cache->tied_in == tied) &&
+			    (cache->rank_in == *rank) &&
+			    (cache->rnt_in == *rnt)) {
+				*rank = cache->rank_out;
+				*rnt = cache->rnt_out;
+				ft_reused_cnt++;
+				prev_level_fs = assoc->usage->level_fs;
+				continue;
+			}
+			cache->tied_in = tied;
+			cache->rank_in = *rank;
+			cache->rnt_in = *rnt;
 
 			/* Merging does not affect child level_fs calculations
 			 * since the necessary information is stored on each
@@ -385,7 +519,16 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 						   assoc_level);
 
 			_calc_tree_fs(children, assoc_level+1,
-				      rank, rnt, tied);
+				      rank, rnt, tied,
+				      merge_count ? NULL : cache);
+			ft_ranked_cnt++;
+
+			/* Merged children are not ranked per account */
+			cache->valid = !merge_count;
+			cache->rank_out = *rank;
+			cache->rnt_out = *rnt;
+			for (size_t m = 1; m <= merge_count; m++)
+				_ft_cache_get(siblings[i + m])->valid = false;
 
 			/* Skip over any merged accounts */
 			i += merge_count;
@@ -398,6 +541,46 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 }
 
 
+/*
+ * Calculate level_fs for every child of assoc, recursively, and mark the
+ * cache entry of each account whose subtree would now be ranked differently.
+ * A change beneath an account also marks every account on the path up to
+ * the root.
+ * RET true if anything beneath assoc changed
+ */
+static bool _ft_refresh_children(slurmdb_assoc_rec_t *assoc)
+{
+	ft_cache_t *cache = _ft_cache_get(assoc);
+	List children = assoc->usage->children_list;
+	slurmdb_assoc_rec_t *child;
+	ListIterator itr;
+	uint64_t child_sig = 0;
+	bool dirty = !cache->valid;
+
+	if (children) {
+		itr = list_iterator_create(children);
+		while ((child = list_next(itr))) {
+			_calc_assoc_fs(child);
+			if (!child->user && _ft_refresh_children(child))
+				dirty = true;
+			child_sig = (child_sig * 31) + child->id +
+				    (uintptr_t) child->usage;
+		}
+		list_iterator_destroy(itr);
+	}
+
+	/* The cached order may only be read once the children are known to
+	 * be the same ones */
+	if ((cache->child_sig != child_sig) || (cache->usage != assoc->usage) ||
+	    _ft_order_changed(cache))
+		dirty = true;
+	cache->child_sig = child_sig;
+	cache->usage = assoc->usage;
+	cache->dirty = dirty;
+
+	return dirty;
+}
+
 /* Start fairshare calculations at root. Call assoc_mgr_lock before this. */
 static void _apply_priority_fs(void)
 {
@@ -408,7 +591,26 @@ static void _apply_priority_fs(void)
 
 	log_flag(PRIO, "Fair Tree fairshare algorithm, starting at root:");
 
+	/*
+	 * Rank everything from scratch when the tree was reloaded, the user
+	 * count changed (it scales every fs_factor), the plugin asked for it,
+	 * or the whole tree is to be logged.
+	 */
+	if (!ft_cache || (ft_cache_root != assoc_mgr_root_assoc) ||
+	    (ft_cache_users != g_user_assoc_count) ||
+	    (ft_cache_gen != ft_reset_gen) ||
+	    (slurm_conf.debug_flags & DEBUG_FLAG_PRIO)) {
+		if (ft_cache)
+			xhash_free(ft_cache);
+		ft_cache = xhash_init(_ft_cache_id, _ft_cache_free);
+		ft_cache_root = assoc_mgr_root_assoc;
+		ft_cache_users = g_user_assoc_count;
+		ft_cache_gen = ft_reset_gen;
+	}
+	ft_ranked_cnt = ft_reused_cnt = 0;
+
 	assoc_mgr_root_assoc->usage->level_fs = (long double) NO_VAL;
+	_ft_refresh_children(assoc_mgr_root_assoc);
 
 	/* _calc_tree_fs requires an array instead of List */
 	children = _append_list_to_array(
@@ -416,7 +618,11 @@ static void _apply_priority_fs(void)
 		children,
 		&child_count);
 
-	_calc_tree_fs(children, 0, &rank, &rnt, false);
+	_calc_tree_fs(children, 0, &rank, &rnt, false,
+		      _ft_cache_get(assoc_mgr_root_assoc));
 
 	xfree(children);
+
+	log_flag(PRIO, "Fair Tree: ranked %u accounts, reused %u unchanged accounts",
+		 ft_ranked_cnt, ft_reused_cnt);
 }
@@ -43,4 +43,10 @@
 /* Fair Tree code called from the decay thread loop */
 extern void fair_tree_decay(List jobs, time_t start);
 
+/* Discard the cached ranking, the next pass ranks the whole tree */
+extern void fair_tree_reset(void);
+
+/* Free the cached ranking */
+extern void fair_tree_fini(void);
+
 #endif
@@ -56,6 +56,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "slurm/slurm_errno.h"
 
@@ -64,6 +65,8 @@
 #include "src/common/slurm_mcs.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_time.h"
+#include "src/common/timers.h"
+#include "src/common/workq.h"
 #include "src/common/xstring.h"
 #include "src/common/gres.h"
 
@@ -75,6 +78,10 @@
 #define SECS_PER_DAY	(24 * 60 * 60)
 #define SECS_PER_WEEK	(7 * SECS_PER_DAY)
 
+#define DECAY_THREADS_DEFAULT	8	/* cap on default decay_threads */
+#define DECAY_THREADS_MAX	64	/* cap on configured decay_threads */
+#define DECAY_CHUNK_MIN		256	/* fewest jobs handed to one thread */
+
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -87,6 +94,7 @@ extern time_t last_job_update __attribute__((weak_import));
 extern slurm_conf_t slurm_conf __attribute__((weak_import));
 extern int slurmctld_tres_cnt __attribute__((weak_import));
 extern uint16_t accounting_enforce __attribute__((weak_import));
+extern diag_stats_t slurmctld_diag_stats __attribute__((weak_import));
 #else
 void *acct_db_conn = NULL;
 uint32_t cluster_cpus = NO_VAL;
@@ -95,6 +103,7 @@ time_t last_job_update = (time_t) 0;
 slurm_conf_t slurm_conf;
 int slurmctld_tres_cnt = 0;
 uint16_t accounting_enforce = 0;
+diag_stats_t slurmctld_diag_stats;
 #endif
 
 /*
@@ -147,6 +156,31 @@ static uint32_t flags;       /* Priority Flags */
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
+/*
+ * Job priorities are recalculated by the decay thread plus
+ * (decay_threads - 1) workers of decay_workq, each taking a slice of the
+ * job array. decay_workq is only touched by the decay thread.
+ */
+static int decay_threads = 1;
+static int decay_workq_threads = 0;
+static workq_t *decay_workq = NULL;
+static pthread_mutex_t decay_chunk_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t decay_chunk_cond = PTHREAD_COND_INITIALIZER;
+static int decay_chunk_cnt = 0;
+
+typedef struct {
+	job_record_t **jobs;
+	int job_cnt;
+	time_t start_time;
+	bool changed;
+} decay_chunk_t;
+
+typedef struct {
+	job_record_t **jobs;
+	int job_cnt;
+	time_t *start_time_ptr;
+} decay_collect_t;
+
 /* variables defined in priority_multifactor.h */
 
 static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc);
@@ -225,6 +259,7 @@ static int _reset_usage(void)
 	if (!calc_fairshare)
 		return SLURM_SUCCESS;
 
+	fair_tree_reset();
 	assoc_mgr_lock(&locks);
 
 	xassert(assoc_mgr_assoc_list);
@@ -402,6 +437,15 @@ static int _set_children_usage_efctv(List children_list)
 }
 
 
+/* Association the fairshare factor of a job using job_assoc comes from */
+static slurmdb_assoc_rec_t *_get_fs_assoc(slurmdb_assoc_rec_t *job_assoc)
+{
+	/* Use values from parent when FairShare=SLURMDB_FS_USE_PARENT */
+	if (job_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
+		return job_assoc->usage->fs_assoc_ptr;
+	return job_assoc;
+}
+
 /* job_ptr should already have the partition priority and such added here
  * before had we will be adding to it
  */
@@ -427,11 +471,7 @@ static double _get_fairshare_priority(job_record_t *job_ptr)
 		return 0;
 	}
 
-	/* Use values from parent when FairShare=SLURMDB_FS_USE_PARENT */
-	if (job_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
-		fs_assoc = job_assoc->usage->fs_assoc_ptr;
-	else
-		fs_assoc = job_assoc;
+	fs_assoc = _get_fs_assoc(job_assoc);
 
 	if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
 		priority_p_set_assoc_usage(fs_assoc);
@@ -1164,6 +1204,174 @@ static int _apply_new_usage(job_record_t *job_ptr, time_t start_period,
 }
 
 
+/*
+ * Recalculate the priority of one job.
+ * Only fields of job_ptr are modified, so different jobs may be handled
+ * concurrently as long as the caller holds the job write lock.
+ * RET true if the job's priority was (re)set
+ */
+static bool _set_weighted_prio(job_record_t *job_ptr, time_t start_time)
+{
+	uint32_t new_prio;
+	bool changed = false;
+
+	/*
+	 * Priority 0 is reserved for held jobs. Also skip priority
+	 * re_calculation for non-pending jobs.
+	 */
+	if ((job_ptr->priority == 0) ||
+	    IS_JOB_POWER_UP_NODE(job_ptr) ||
+	    (!IS_JOB_PENDING(job_ptr) &&
+	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
+		return false;
+
+	new_prio = _get_priority_internal(start_time, job_ptr);
+	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
+	    (job_ptr->priority < new_prio)) {
+		job_ptr->priority = new_prio;
+		changed = true;
+	}
+
+	debug2("priority for job %u is now %u",
+	       job_ptr->job_id, job_ptr->priority);
+
+	return changed;
+}
+
+static void _decay_chunk(void *arg)
+{
+	decay_chunk_t *chunk = arg;
+
+	for (int i = 0; i < chunk->job_cnt; i++) {
+		if (_set_weighted_prio(chunk->jobs[i], chunk->start_time))
+			chunk->changed = true;
+	}
+
+	slurm_mutex_lock(&decay_chunk_lock);
+	if (--decay_chunk_cnt == 0)
+		slurm_cond_signal(&decay_chunk_cond);
+	slurm_mutex_unlock(&decay_chunk_lock);
+}
+
+/*
+ * _get_fairshare_priority() fills in a NO_VAL usage_efctv of the job's
+ * fairshare association, which is a write to the shared association. The
+ * decay workers only hold the assoc read lock, so do it for all the jobs
+ * here first, leaving the workers nothing to write in the associations.
+ */
+static void _set_jobs_assoc_usage(job_record_t **jobs, int job_cnt)
+{
+	assoc_mgr_lock_t locks = { .assoc = WRITE_LOCK };
+	slurmdb_assoc_rec_t *fs_assoc;
+
+	if (!calc_fairshare)
+		return;
+
+	assoc_mgr_lock(&locks);
+	for (int i = 0; i < job_cnt; i++) {
+		if (!jobs[i]->assoc_ptr)
+			continue;
+		fs_assoc = _get_fs_assoc(jobs[i]->assoc_ptr);
+		if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
+			priority_p_set_assoc_usage(fs_assoc);
+	}
+	assoc_mgr_unlock(&locks);
+}
+
+/*
+ * Recalculate the priority of every job in the array, splitting the array
+ * between the decay thread and the decay_workq workers.
+ * Caller must hold the job write lock.
+ */
+static void _set_weighted_prio_array(job_record_t **jobs, int job_cnt,
+				     time_t start_time)
+{
+	decay_chunk_t *chunks;
+	int chunk_cnt, per_chunk, offset = 0;
+	bool changed = false;
+
+	chunk_cnt = MIN(decay_workq_threads + 1, job_cnt / DECAY_CHUNK_MIN);
+	if (!decay_workq || (chunk_cnt < 2)) {
+		for (int i = 0; i < job_cnt; i++) {
+			if (_set_weighted_prio(jobs[i], start_time))
+				changed = true;
+		}
+		if (changed)
+			last_job_update = time(NULL);
+		return;
+	}
+
+	_set_jobs_assoc_usage(jobs, job_cnt);
+
+	chunks = xcalloc(chunk_cnt, sizeof(*chunks));
+	per_chunk = (job_cnt + chunk_cnt - 1) / chunk_cnt;
+	for (int i = 0; i < chunk_cnt; i++) {
+		chunks[i].jobs = jobs + offset;
+		chunks[i].job_cnt = MIN(per_chunk, job_cnt - offset);
+		chunks[i].start_time = start_time;
+		offset += chunks[i].job_cnt;
+	}
+
+	/* The decay thread works the first chunk itself */
+	decay_chunk_cnt = chunk_cnt;
+	for (int i = 1; i < chunk_cnt; i++) {
+		if (workq_add_work(decay_workq, _decay_chunk, &chunks[i],
+				   0) != SLURM_SUCCESS)
+			_decay_chunk(&chunks[i]);
+	}
+	_decay_chunk(&chunks[0]);
+
+	slurm_mutex_lock(&decay_chunk_lock);
+	while (decay_chunk_cnt)
+		slurm_cond_wait(&decay_chunk_cond, &decay_chunk_lock);
+	slurm_mutex_unlock(&decay_chunk_lock);
+
+	for (int i = 0; i < chunk_cnt; i++)
+		changed |= chunks[i].changed;
+	if (changed)
+		last_job_update = time(NULL);
+
+	log_flag(PRIO, "%s: recalculated %d job priorities in %d chunks",
+		 __func__, job_cnt, chunk_cnt);
+	xfree(chunks);
+}
+
+static int _decay_apply_new_usage_and_collect(job_record_t *job_ptr,
+					      decay_collect_t *collect)
+{
+	/* Always return SUCCESS so that list_for_each will
+	 * continue processing list of jobs. */
+
+	if (!decay_apply_new_usage(job_ptr, collect->start_time_ptr))
+		return SLURM_SUCCESS;
+
+	collect->jobs[collect->job_cnt++] = job_ptr;
+
+	return SLURM_SUCCESS;
+}
+
+static int _collect_job(job_record_t *job_ptr, decay_collect_t *collect)
+{
+	collect->jobs[collect->job_cnt++] = job_ptr;
+
+	return SLURM_SUCCESS;
+}
+
+/* (Re)size decay_workq to match decay_threads. Only the decay thread calls */
+static void _decay_workq_sync(void)
+{
+	int workers = decay_threads - 1;
+
+	if (workers == decay_workq_threads)
+		return;
+
+	FREE_NULL_WORKQ(decay_workq);
+	if (workers > 0)
+		decay_workq = new_workq(workers);
+	decay_workq_threads = workers;
+	log_flag(PRIO, "priority: using %d decay threads", decay_threads);
+}
+
 static int _decay_apply_new_usage_and_weighted_factors(job_record_t *job_ptr,
 						       time_t *start_time_ptr)
 {
@@ -1190,6 +1398,7 @@ static void *_decay_thread(void *no_data)
 	double run_delta = 0.0, real_decay = 0.0;
 	struct timeval tvnow;
 	struct timespec abs;
+	DEF_TIMERS;
 
 	/* Write lock on jobs, read lock on nodes and partitions */
 	slurmctld_lock_t job_write_lock =
@@ -1280,6 +1489,9 @@ static void *_decay_thread(void *no_data)
 			reconfig = 0;
 		}
 
+		START_TIMER;
+		_decay_workq_sync();
+
 		/* this needs to be done right away so as to
 		 * incorporate it into the decay loop.
 		 */
@@ -1349,11 +1561,23 @@ static void *_decay_thread(void *no_data)
 		site_factor_g_update();
 
 		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
+			decay_collect_t collect = {
+				.start_time_ptr = &start_time,
+			};
+
+			/*
+			 * Usage is charged to shared associations, so it is
+			 * applied serially. The priority pass is parallel.
+			 */
+			collect.jobs = xcalloc(list_count(job_list) + 1,
+					       sizeof(job_record_t *));
 			list_for_each(
 				job_list,
-				(ListForF) _decay_apply_new_usage_and_weighted_factors,
-				&start_time
-				);
+				(ListForF) _decay_apply_new_usage_and_collect,
+				&collect);
+			_set_weighted_prio_array(collect.jobs, collect.job_cnt,
+						 start_time);
+			xfree(collect.jobs);
 		}
 
 		unlock_slurmctld(job_write_lock);
@@ -1364,6 +1588,15 @@ static void *_decay_thread(void *no_data)
 
 		g_last_ran = start_time;
 
+		END_TIMER;
+		slurmctld_diag_stats.decay_cycle_counter++;
+		slurmctld_diag_stats.decay_cycle_last = DELTA_TIMER;
+		slurmctld_diag_stats.decay_cycle_sum += DELTA_TIMER;
+		if (slurmctld_diag_stats.decay_cycle_last >
+		    slurmctld_diag_stats.decay_cycle_max)
+			slurmctld_diag_stats.decay_cycle_max =
+				slurmctld_diag_stats.decay_cycle_last;
+
 		_write_last_decay_ran(g_last_ran, last_reset);
 
 		running_decay = 0;
@@ -1510,6 +1743,23 @@ static void _filter_job(job_record_t *job_ptr,
 	list_iterator_destroy(job_iter);
 }
 
+static void _parse_priority_params(void)
+{
+	char *tmp_ptr;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	decay_threads = MIN(MAX(cpus, 1), DECAY_THREADS_DEFAULT);
+	if ((tmp_ptr = xstrcasestr(slurm_conf.priority_params,
+				   "decay_threads="))) {
+		int i = atoi(tmp_ptr + 14);
+		if ((i < 1) || (i > DECAY_THREADS_MAX)) {
+			error("Invalid PriorityParameters decay_threads=%d, using %d",
+			      i, decay_threads);
+		} else
+			decay_threads = i;
+	}
+}
+
 static void _internal_setup(void)
 {
 	damp_factor = (long double) slurm_conf.fs_dampening_factor;
@@ -1524,6 +1774,7 @@ static void _internal_setup(void)
 	weight_tres = slurm_get_tres_weight_array(
 		slurm_conf.priority_weight_tres, slurmctld_tres_cnt, true);
 	flags = slurm_conf.priority_flags;
+	_parse_priority_params();
 
 	log_flag(PRIO, "priority: Damp Factor is %u", damp_factor);
 	log_flag(PRIO, "priority: AccountingStorageEnforce is %u",
@@ -1536,6 +1787,7 @@ static void _internal_setup(void)
 	log_flag(PRIO, "priority: Weight Part is %u", weight_part);
 	log_flag(PRIO, "priority: Weight QOS is %u", weight_qos);
 	log_flag(PRIO, "priority: Flags is %u", flags);
+	log_flag(PRIO, "priority: Decay threads is %d", decay_threads);
 }
 
 
@@ -1779,6 +2031,10 @@ int fini ( void )
 	if (decay_handler_thread)
 		pthread_join(decay_handler_thread, NULL);
 
+	FREE_NULL_WORKQ(decay_workq);
+	decay_workq_threads = 0;
+	fair_tree_fini();
+
 	site_factor_plugin_fini();
 
 	return SLURM_SUCCESS;
@@ -1808,6 +2064,7 @@ extern void priority_p_reconfig(bool assoc_clear)
 
 	reconfig = 1;
 	_internal_setup();
+	fair_tree_reset();
 
 	/* Since Fair Tree uses a different shares calculation method, we
 	 * must reassign shares at reconfigure if the algorithm was switched to
@@ -2004,34 +2261,25 @@ extern bool decay_apply_new_usage(job_record_t *job_ptr,
 extern int decay_apply_weighted_factors(job_record_t *job_ptr,
 					time_t *start_time_ptr)
 {
-	uint32_t new_prio;
-
 	/* Always return SUCCESS so that list_for_each will
 	 * continue processing list of jobs. */
 
-	/*
-	 * Priority 0 is reserved for held jobs. Also skip priority
-	 * re_calculation for non-pending jobs.
-	 */
-	if ((job_ptr->priority == 0) ||
-	    IS_JOB_POWER_UP_NODE(job_ptr) ||
-	    (!IS_JOB_PENDING(job_ptr) &&
-	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
-		return SLURM_SUCCESS;
-
-	new_prio = _get_priority_internal(*start_time_ptr, job_ptr);
-	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
-	    (job_ptr->priority < new_prio)) {
-		job_ptr->priority = new_prio;
+	if (_set_weighted_prio(job_ptr, *start_time_ptr))
 		last_job_update = time(NULL);
-	}
-
-	debug2("priority for job %u is now %u",
-	       job_ptr->job_id, job_ptr->priority);
 
 	return SLURM_SUCCESS;
 }
 
+extern void decay_apply_weighted_factors_list(List jobs, time_t start_time)
+{
+	decay_collect_t collect = { 0 };
+
+	collect.jobs = xcalloc(list_count(jobs) + 1, sizeof(job_record_t *));
+	list_for_each(jobs, (ListForF) _collect_job, &collect);
+	_set_weighted_prio_array(collect.jobs, collect.job_cnt, start_time);
+	xfree(collect.jobs);
+}
+
 
 extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 {
@@ -128,7 +128,8 @@
 typedef struct node_space_map {
 	time_t begin_time;
 	time_t end_time;
-	bitstr_t *avail_bitmap;
+	bitstr_t *avail_bitmap;	/* shared copy-on-write, see avail_ref_cnt */
+	int *avail_ref_cnt;	/* count of records sharing avail_bitmap */
 	int next;	/* next record, by time, zero termination */
 } node_space_map_t;
 
@@ -216,6 +217,13 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     node_space_map_t *node_space,
 			     int *node_space_recs);
 static void _adjust_hetjob_prio(uint32_t *prio, uint32_t val);
+static void _node_space_and(node_space_map_t *node_space, int inx,
+			    bitstr_t *res_bitmap);
+static void _node_space_release(node_space_map_t *node_space, int inx);
+static void _node_space_share(node_space_map_t *node_space, int dst_inx,
+			      int src_inx);
+static void _node_space_revalidate(node_space_map_t *node_space,
+				   bitstr_t **node_snapshot);
 static int  _attempt_backfill(void);
 static int  _clear_job_estimates(void *x, void *arg);
 static int  _clear_qos_blocked_times(void *x, void *arg);
@@ -1553,6 +1561,7 @@ static int _attempt_backfill(void)
 {
 	DEF_TIMERS;
 	List job_queue;
+	job_queue_heap_t *job_queue_heap;
 	job_queue_rec_t *job_queue_rec;
 	int bb, i, j, node_space_recs, mcs_select = 0;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
@@ -1579,6 +1588,8 @@ static int _attempt_backfill(void)
 	struct timeval start_tv;
 	uint32_t test_array_job_id = 0;
 	uint32_t test_array_count = 0;
+	xhash_t *failed_classes = NULL;
+	uint64_t job_class = 0;
 	uint32_t job_no_reserve;
 	bool is_job_array_head, resv_overlap = false;
 	uint8_t save_share_res = 0, save_whole_node = 0;
@@ -1587,7 +1598,7 @@ static int _attempt_backfill(void)
 	time_t qos_blocked_until = 0, qos_part_blocked_until = 0;
 	time_t tmp_preempt_start_time = 0;
 	bool tmp_preempt_in_progress = false;
-	bitstr_t *tmp_bitmap = NULL;
+	bitstr_t *tmp_bitmap = NULL, *node_snapshot = NULL;
 	/* QOS Read lock */
 	assoc_mgr_lock_t qos_read_lock =
 		{ NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
@@ -1648,6 +1659,10 @@ static int _attempt_backfill(void)
 	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
 	/* Make "resuming" nodes available to be scheduled in backfill */
 	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
+	node_space[0].avail_ref_cnt = xmalloc(sizeof(int));
+	*node_space[0].avail_ref_cnt = 1;
+	if (backfill_continue)
+		node_snapshot = bit_copy(node_space[0].avail_bitmap);
 
 	node_space[0].next = 0;
 	node_space_recs = 1;
@@ -1671,7 +1686,8 @@ static int _attempt_backfill(void)
 		assoc_mgr_unlock(&qos_read_lock);
 	}
 
-	sort_job_queue(job_queue);
+	job_queue_heap = job_queue_heap_create(job_queue);
+	failed_classes = sched_class_table_create();
 
 	/* Ignore nodes that have been set as available during this cycle. */
 	bit_clear_all(bf_ignore_node_bitmap);
@@ -1690,7 +1706,7 @@ static int _attempt_backfill(void)
 			_restore_preempt_state(job_ptr, &tmp_preempt_start_time,
 			                       &tmp_preempt_in_progress);
 		}
-		job_queue_rec = (job_queue_rec_t *) list_pop(job_queue);
+		job_queue_rec = job_queue_heap_pop(job_queue_heap);
 		if (!job_queue_rec) {
 			log_flag(BACKFILL, "reached end of job queue");
 			break;
@@ -1737,6 +1753,7 @@ static int _attempt_backfill(void)
 			}
 			if (stop_backfill)
 				break;
+			_node_space_revalidate(node_space, &node_snapshot);
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
 			gettimeofday(&start_tv, NULL);
@@ -1937,6 +1954,21 @@ next_task:
 			continue;
 		}
 
+		/*
+		 * Once bf_max_job_array_resv jobs identical to this one have
+		 * failed to start now, this one can not start now either, so
+		 * leave the remaining reservations to other jobs.
+		 */
+		job_class = job_sched_class(job_ptr);
+		if (sched_class_fail_cnt(failed_classes, job_class) >=
+		    MAX(bf_max_job_array_resv, 1)) {
+			log_flag(BACKFILL, "%pJ skipped, same requirements as %u jobs that can not start now",
+				 job_ptr,
+				 sched_class_fail_cnt(failed_classes,
+						      job_class));
+			continue;
+		}
+
 		log_flag(BACKFILL, "test for %pJ Prio=%u Partition=%s",
 			 job_ptr, job_ptr->priority, job_ptr->part_ptr->name);
 
@@ -2068,6 +2100,7 @@ next_task:
 			}
 			if (stop_backfill)
 				break;
+			_node_space_revalidate(node_space, &node_snapshot);
 
 			/* Reset backfill scheduling timers, resume testing */
 			sched_start = time(NULL);
@@ -2308,6 +2341,7 @@ next_task:
 				goto TRY_LATER;
 			}
 			job_ptr->start_time = orig_start_time;
+			sched_class_add_fail(failed_classes, job_class);
 			continue;	/* not runable in this partition */
 		}
 
@@ -2527,6 +2561,7 @@ skip_start:
 		}
 
 		if ((job_ptr->start_time > now) && (job_no_reserve != 0)) {
+			sched_class_add_fail(failed_classes, job_class);
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
 				/* Can start earlier in different partition */
@@ -2690,6 +2725,7 @@ skip_start:
 		/* Clear assumed rejected array status */
 		reject_array_job = NULL;
 		reject_array_part = NULL;
+		sched_class_add_fail(failed_classes, job_class);
 
 		if ((orig_start_time == 0) ||
 		    (job_ptr->start_time < orig_start_time)) {
@@ -2751,14 +2787,17 @@ skip_start:
 	FREE_NULL_BITMAP(avail_bitmap);
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
+	FREE_NULL_BITMAP(node_snapshot);
 
 	for (i = 0; ; ) {
-		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
+		_node_space_release(node_space, i);
 		if ((i = node_space[i].next) == 0)
 			break;
 	}
 	xfree(node_space);
 	FREE_NULL_LIST(job_queue);
+	job_queue_heap_free(job_queue_heap);
+	xhash_free(failed_classes);
 
 	gettimeofday(&bf_time2, NULL);
 	_do_diag_stats(&bf_time1, &bf_time2, node_space_recs);
@@ -2941,6 +2980,95 @@ static bool _more_work (time_t last_backfill_time)
 	return rc;
 }
 
+/*
+ * Make a resources/time table record share the bitmap of another record.
+ * The bitmap is only copied once one of the records needs to modify it.
+ */
+static void _node_space_share(node_space_map_t *node_space, int dst_inx,
+			      int src_inx)
+{
+	node_space[dst_inx].avail_bitmap = node_space[src_inx].avail_bitmap;
+	node_space[dst_inx].avail_ref_cnt = node_space[src_inx].avail_ref_cnt;
+	(*node_space[dst_inx].avail_ref_cnt)++;
+	slurmctld_diag_stats.bf_slice_reused++;
+}
+
+/* Drop a record's reference to its bitmap, freeing it with the last one */
+static void _node_space_release(node_space_map_t *node_space, int inx)
+{
+	if (node_space[inx].avail_ref_cnt &&
+	    (--(*node_space[inx].avail_ref_cnt) == 0)) {
+		FREE_NULL_BITMAP(node_space[inx].avail_bitmap);
+		xfree(node_space[inx].avail_ref_cnt);
+	}
+	node_space[inx].avail_bitmap = NULL;
+	node_space[inx].avail_ref_cnt = NULL;
+}
+
+/*
+ * Remove nodes not in res_bitmap from a record's available nodes.
+ * A shared bitmap is only copied if the operation would change it.
+ */
+static void _node_space_and(node_space_map_t *node_space, int inx,
+			    bitstr_t *res_bitmap)
+{
+	if (bit_super_set(node_space[inx].avail_bitmap, res_bitmap))
+		return;
+
+	if (*node_space[inx].avail_ref_cnt > 1) {
+		(*node_space[inx].avail_ref_cnt)--;
+		node_space[inx].avail_bitmap =
+			bit_copy(node_space[inx].avail_bitmap);
+		node_space[inx].avail_ref_cnt = xmalloc(sizeof(int));
+		*node_space[inx].avail_ref_cnt = 1;
+		slurmctld_diag_stats.bf_slice_copied++;
+	}
+	bit_and(node_space[inx].avail_bitmap, res_bitmap);
+}
+
+/*
+ * Compare the node state snapshot taken when the resources/time table was
+ * built (or last revalidated) against current node state after the locks
+ * were yielded. Nodes which became unavailable in the meantime are removed
+ * from every time slot, so that no further reservations or job starts are
+ * planned against them. Nodes which became available are not added, since
+ * running jobs may have been reserved on them in later time slots.
+ */
+static void _node_space_revalidate(node_space_map_t *node_space,
+				   bitstr_t **node_snapshot)
+{
+	bitstr_t *cur_bitmap, *lost_bitmap;
+	int j, lost_cnt;
+
+	if (!*node_snapshot)
+		return;
+
+	cur_bitmap = bit_copy(avail_node_bitmap);
+	bit_or(cur_bitmap, rs_node_bitmap);
+	if (bit_equal(cur_bitmap, *node_snapshot)) {
+		FREE_NULL_BITMAP(cur_bitmap);
+		return;
+	}
+
+	lost_bitmap = bit_copy(*node_snapshot);
+	bit_and_not(lost_bitmap, cur_bitmap);
+	lost_cnt = bit_set_count(lost_bitmap);
+	if (lost_cnt) {
+		log_flag(BACKFILL, "%d nodes became unavailable while locks were released, removing them from the backfill map",
+			 lost_cnt);
+		bit_not(lost_bitmap);
+		for (j = 0; ; ) {
+			_node_space_and(node_space, j, lost_bitmap);
+			if ((j = node_space[j].next) == 0)
+				break;
+		}
+	}
+	FREE_NULL_BITMAP(lost_bitmap);
+
+	FREE_NULL_BITMAP(*node_snapshot);
+	*node_snapshot = cur_bitmap;
+}
+
 /* Create a reservation for a job in the future */
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     bitstr_t *res_bitmap,
@@ -2969,8 +3097,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			node_space[i].begin_time = start_time;
 			node_space[i].end_time = node_space[j].end_time;
 			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
+			_node_space_share(node_space, i, j);
 			node_space[i].next = node_space[j].next;
 			node_space[j].next = i;
 			(*node_space_recs)++;
@@ -2989,9 +3116,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 					node_space[i].end_time = node_space[j].
 								 end_time;
 					node_space[j].end_time = end_reserve;
-					node_space[i].avail_bitmap =
-						bit_copy(node_space[j].
-							 avail_bitmap);
+					_node_space_share(node_space, i, j);
 					node_space[i].next = node_space[j].next;
 					node_space[j].next = i;
 					(*node_space_recs)++;
@@ -3010,7 +3135,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 	for (j = 0; ; ) {
 		if ((node_space[j].begin_time >= start_time) &&
 		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
+			_node_space_and(node_space, j, res_bitmap);
 		if ((node_space[j].begin_time >= end_reserve) ||
 		    ((j = node_space[j].next) == 0))
 			break;
@@ -3021,14 +3146,16 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 	for (i = 0; ; ) {
 		if ((j = node_space[i].next) == 0)
 			break;
-		if (!bit_equal(node_space[i].avail_bitmap,
+		if ((node_space[i].avail_bitmap !=
+		     node_space[j].avail_bitmap) &&
+		    !bit_equal(node_space[i].avail_bitmap,
 			       node_space[j].avail_bitmap)) {
 			i = j;
 			continue;
 		}
 		node_space[i].end_time = node_space[j].end_time;
 		node_space[i].next = node_space[j].next;
-		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
+		_node_space_release(node_space, j);
 		break;
 	}
 }
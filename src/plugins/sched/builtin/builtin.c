@@ -139,6 +139,7 @@ static void _compute_start_times(void)
 {
 	int j, rc = SLURM_SUCCESS, job_cnt = 0;
 	List job_queue;
+	job_queue_heap_t *job_queue_heap;
 	job_queue_rec_t *job_queue_rec;
 	job_record_t *job_ptr;
 	part_record_t *part_ptr;
@@ -152,8 +153,8 @@ static void _compute_start_times(void)
 	last_job_alloc = now - 1;
 	alloc_bitmap = bit_alloc(node_record_count);
 	job_queue = build_job_queue(true, false);
-	sort_job_queue(job_queue);
-	while ((job_queue_rec = (job_queue_rec_t *) list_pop(job_queue))) {
+	job_queue_heap = job_queue_heap_create(job_queue);
+	while ((job_queue_rec = job_queue_heap_pop(job_queue_heap))) {
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
 		xfree(job_queue_rec);
@@ -231,6 +232,7 @@ static void _compute_start_times(void)
 		}
 	}
 	FREE_NULL_LIST(job_queue);
+	job_queue_heap_free(job_queue_heap);
 	FREE_NULL_BITMAP(alloc_bitmap);
 }
 
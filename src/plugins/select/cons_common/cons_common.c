@@ -57,6 +57,7 @@ extern List part_list __attribute__((weak_import));
 extern List job_list __attribute__((weak_import));
 extern int node_record_count __attribute__((weak_import));
 extern time_t last_node_update __attribute__((weak_import));
+extern time_t last_part_update __attribute__((weak_import));
 extern switch_record_t *switch_record_table __attribute__((weak_import));
 extern int switch_record_cnt __attribute__((weak_import));
 extern bitstr_t *avail_node_bitmap __attribute__((weak_import));
@@ -65,6 +66,7 @@ extern uint32_t *cr_node_cores_offset __attribute__((weak_import));
 extern int slurmctld_tres_cnt __attribute__((weak_import));
 extern slurmctld_config_t slurmctld_config __attribute__((weak_import));
 extern bitstr_t *idle_node_bitmap __attribute__((weak_import));
+extern diag_stats_t slurmctld_diag_stats __attribute__((weak_import));
 #else
 slurm_conf_t slurm_conf;
 node_record_t *node_record_table_ptr;
@@ -72,6 +74,7 @@ List part_list;
 List job_list;
 int node_record_count;
 time_t last_node_update;
+time_t last_part_update;
 switch_record_t *switch_record_table;
 int switch_record_cnt;
 bitstr_t *avail_node_bitmap;
@@ -80,6 +83,7 @@ uint32_t *cr_node_cores_offset;
 int slurmctld_tres_cnt = 0;
 slurmctld_config_t slurmctld_config;
 bitstr_t *idle_node_bitmap;
+diag_stats_t slurmctld_diag_stats;
 #endif
 
 /* init common global variables */
@@ -794,6 +798,7 @@ extern void common_fini(void)
 	select_node_usage = NULL;
 	part_data_destroy_res(select_part_record);
 	select_part_record = NULL;
+	common_job_test_fini();
 	cr_fini_global_core_data();
 }
 
@@ -1027,6 +1032,7 @@ extern int select_p_node_init(node_record_t *node_ptr, int node_cnt)
 		error("select_p_node_init: node_ptr == NULL");
 		return SLURM_ERROR;
 	}
+	select_state_gen++;
 	if (node_cnt < 0) {
 		error("select_p_node_init: node_cnt < 0");
 		return SLURM_ERROR;
@@ -1417,6 +1423,7 @@ extern int select_p_job_resized(job_record_t *job_ptr, node_record_t *node_ptr)
 	xassert(job_ptr);
 	xassert(job_ptr->magic == JOB_MAGIC);
 
+	select_state_gen++;
 	if (!job || !job->core_bitmap) {
 		error("%pJ has no job_resrcs info",
 		      job_ptr);
@@ -1557,6 +1564,7 @@ extern int select_p_job_mem_confirm(job_record_t *job_ptr)
 	    (job_ptr->job_resrcs->node_bitmap == NULL) ||
 	    (job_ptr->job_resrcs->memory_allocated == NULL))
 		return SLURM_ERROR;
+	select_state_gen++;
 	i_first = bit_ffs(job_ptr->job_resrcs->node_bitmap);
 	if (i_first >= 0)
 		i_last = bit_fls(job_ptr->job_resrcs->node_bitmap);
@@ -2043,6 +2051,7 @@ extern int select_p_update_node_config(int index)
 		      select_node_cnt);
 		return SLURM_ERROR;
 	}
+	select_state_gen++;
 
 	/*
 	 * Socket and core count can be changed when KNL node reboots in a
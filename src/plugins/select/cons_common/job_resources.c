@@ -41,6 +41,7 @@
 #include "src/slurmctld/gres_ctld.h"
 
 bool select_state_initializing = true;
+uint64_t select_state_gen = 0;
 
 typedef enum {
 	HANDLE_JOB_RES_ADD,
@@ -324,6 +325,8 @@ extern int job_res_add_job(job_record_t *job_ptr, job_res_job_action_t action)
 	if (slurm_conf.debug_flags & DEBUG_FLAG_SELECT_TYPE)
 		log_job_resources(job_ptr);
 
+	select_state_gen++;
+
 	i_first = bit_ffs(job->node_bitmap);
 	if (i_first != -1)
 		i_last = bit_fls(job->node_bitmap);
@@ -500,6 +503,8 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 		debug3("%pJ action:%s",
 		       job_ptr, job_res_job_action_string(action));
 	}
+	if (node_usage == select_node_usage)
+		select_state_gen++;
 	if (job_ptr->start_time < slurmctld_config.boot_time)
 		old_job = true;
 	i_first = bit_ffs(job->node_bitmap);
@@ -519,6 +524,7 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 
 		node_ptr = node_record_table_ptr + i;
 		if (action != JOB_RES_ACTION_RESUME) {
+			node_data_own_gres(node_usage, i);
 			if (node_usage[i].gres_list)
 				gres_list = node_usage[i].gres_list;
 			else
@@ -573,6 +579,7 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 
 		if (!p_ptr->row)
 			return SLURM_SUCCESS;
+		part_data_own_rows(p_ptr);
 
 		/* remove the job from the job_list */
 		n = 0;
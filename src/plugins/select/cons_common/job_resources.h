@@ -54,6 +54,12 @@ typedef enum {
 
 extern bool select_state_initializing;
 
+/*
+ * Incremented on every change to the live resource state (select_part_record,
+ * select_node_usage and select_node_record), see _feas_cache_lookup()
+ */
+extern uint64_t select_state_gen;
+
 extern char *job_res_job_action_string(job_res_job_action_t action);
 
 /*
@@ -63,6 +63,27 @@ typedef struct {
 	bool *qos_preemptor;
 } cr_job_list_args_t;
 
+/*
+ * Cache of failed SELECT_MODE_RUN_NOW tests. A job which could not be placed
+ * on a given set of nodes is not tested again until its requirements, the
+ * select plugin's resource state (select_state_gen) or the controller's node
+ * or partition tables change.
+ */
+#define FEAS_CACHE_SIZE 4096	/* entries, must be a power of 2 */
+
+typedef struct {
+	uint64_t key;		/* _feas_cache_key() of the test */
+	uint32_t job_id;
+	bitstr_t *node_bitmap;	/* nodes offered to the job */
+	uint64_t state_gen;	/* select_state_gen when recorded */
+	time_t node_update;	/* last_node_update when recorded */
+	time_t part_update;	/* last_part_update when recorded */
+	time_t when;		/* time recorded */
+	int rc;
+} feas_cache_ent_t;
+
+static feas_cache_ent_t feas_cache[FEAS_CACHE_SIZE];
+
 uint64_t def_cpu_per_gpu = 0;
 uint64_t def_mem_per_gpu = 0;
 bool preempt_strict_order = false;
@@ -2235,6 +2256,145 @@ top:	orig_node_map = bit_copy(save_node_map);
 	return rc;
 }
 
+static uint64_t _feas_hash(uint64_t hash, uint64_t val)
+{
+	return (hash ^ val) * 0x100000001b3ULL;	/* FNV-1a */
+}
+
+static uint64_t _feas_hash_str(uint64_t hash, const char *str)
+{
+	if (!str)
+		return _feas_hash(hash, 0);
+	for ( ; *str; str++)
+		hash = _feas_hash(hash, (unsigned char) *str);
+	return _feas_hash(hash, 0);
+}
+
+static uint64_t _feas_hash_bitmap(uint64_t hash, bitstr_t *bitmap)
+{
+	if (!bitmap)
+		return _feas_hash(hash, 0);
+	hash = _feas_hash(hash, bit_size(bitmap));
+	hash = _feas_hash(hash, bit_set_count(bitmap));
+	hash = _feas_hash(hash, bit_ffs(bitmap));
+	return _feas_hash(hash, bit_fls(bitmap));
+}
+
+/*
+ * Build a key from everything a SELECT_MODE_RUN_NOW test depends on apart from
+ * the resource state. The node bitmap is only summarized here, cache entries
+ * keep a copy of it for an exact comparison.
+ */
+static uint64_t _feas_cache_key(job_record_t *job_ptr, bitstr_t *node_bitmap,
+				uint32_t min_nodes, uint32_t max_nodes,
+				uint32_t req_nodes, uint16_t job_node_req)
+{
+	struct job_details *details = job_ptr->details;
+	multi_core_data_t *mc_ptr = details->mc_ptr;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	hash = _feas_hash(hash, job_ptr->job_id);
+	hash = _feas_hash(hash, (uintptr_t) job_ptr->part_ptr);
+	hash = _feas_hash(hash, job_ptr->bit_flags);
+	hash = _feas_hash(hash, min_nodes);
+	hash = _feas_hash(hash, max_nodes);
+	hash = _feas_hash(hash, req_nodes);
+	hash = _feas_hash(hash, job_node_req);
+	hash = _feas_hash_bitmap(hash, node_bitmap);
+
+	hash = _feas_hash(hash, details->min_cpus);
+	hash = _feas_hash(hash, details->max_cpus);
+	hash = _feas_hash(hash, details->pn_min_cpus);
+	hash = _feas_hash(hash, details->pn_min_memory);
+	hash = _feas_hash(hash, details->cpus_per_task);
+	hash = _feas_hash(hash, details->ntasks_per_node);
+	hash = _feas_hash(hash, details->ntasks_per_tres);
+	hash = _feas_hash(hash, details->num_tasks);
+	hash = _feas_hash(hash, details->task_dist);
+	hash = _feas_hash(hash, details->contiguous);
+	hash = _feas_hash(hash, details->core_spec);
+	hash = _feas_hash(hash, details->share_res);
+	hash = _feas_hash(hash, details->overcommit);
+	hash = _feas_hash(hash, details->whole_node);
+	hash = _feas_hash_bitmap(hash, details->req_node_bitmap);
+	if (mc_ptr) {
+		hash = _feas_hash(hash, mc_ptr->sockets_per_node);
+		hash = _feas_hash(hash, mc_ptr->cores_per_socket);
+		hash = _feas_hash(hash, mc_ptr->threads_per_core);
+		hash = _feas_hash(hash, mc_ptr->ntasks_per_socket);
+		hash = _feas_hash(hash, mc_ptr->ntasks_per_core);
+		hash = _feas_hash(hash, mc_ptr->plane_size);
+	}
+
+	hash = _feas_hash_str(hash, job_ptr->cpus_per_tres);
+	hash = _feas_hash_str(hash, job_ptr->mem_per_tres);
+	hash = _feas_hash_str(hash, job_ptr->tres_per_job);
+	hash = _feas_hash_str(hash, job_ptr->tres_per_node);
+	hash = _feas_hash_str(hash, job_ptr->tres_per_socket);
+	hash = _feas_hash_str(hash, job_ptr->tres_per_task);
+
+	return hash;
+}
+
+/*
+ * Return the cached result of an identical failed test, or SLURM_SUCCESS if
+ * the test must be run. An entry is only trusted if it was recorded in an
+ * earlier second than the last node and partition table updates, as those are
+ * only tracked with a resolution of one second.
+ */
+static int _feas_cache_lookup(job_record_t *job_ptr, bitstr_t *node_bitmap,
+			      uint64_t key)
+{
+	feas_cache_ent_t *ent = &feas_cache[key & (FEAS_CACHE_SIZE - 1)];
+
+	if ((ent->key != key) || (ent->job_id != job_ptr->job_id) ||
+	    !ent->node_bitmap ||
+	    (ent->state_gen != select_state_gen) ||
+	    (ent->node_update != last_node_update) ||
+	    (ent->part_update != last_part_update) ||
+	    (ent->when <= ent->node_update) ||
+	    (ent->when <= ent->part_update) ||
+	    !bit_equal(ent->node_bitmap, node_bitmap)) {
+		slurmctld_diag_stats.select_cache_misses++;
+		return SLURM_SUCCESS;
+	}
+
+	slurmctld_diag_stats.select_cache_hits++;
+	log_flag(SELECT_TYPE, "%pJ cached test failure on %d nodes",
+		 job_ptr, bit_set_count(node_bitmap));
+	return ent->rc;
+}
+
+static void _feas_cache_store(job_record_t *job_ptr, bitstr_t *node_bitmap,
+			      uint64_t key, int rc)
+{
+	feas_cache_ent_t *ent = &feas_cache[key & (FEAS_CACHE_SIZE - 1)];
+
+	if (ent->node_bitmap &&
+	    (bit_size(ent->node_bitmap) == bit_size(node_bitmap))) {
+		bit_copybits(ent->node_bitmap, node_bitmap);
+	} else {
+		FREE_NULL_BITMAP(ent->node_bitmap);
+		ent->node_bitmap = bit_copy(node_bitmap);
+	}
+	ent->key = key;
+	ent->job_id = job_ptr->job_id;
+	ent->state_gen = select_state_gen;
+	ent->node_update = last_node_update;
+	ent->part_update = last_part_update;
+	ent->when = time(NULL);
+	ent->rc = rc;
+}
+
+extern void common_job_test_fini(void)
+{
+	int i;
+
+	for (i = 0; i < FEAS_CACHE_SIZE; i++)
+		FREE_NULL_BITMAP(feas_cache[i].node_bitmap);
+	memset(feas_cache, 0, sizeof(feas_cache));
+}
+
 /*
  * common_job_test - Given a specification of scheduling requirements,
  *	identify the nodes which "best" satisfy the request.
@@ -2326,10 +2486,33 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		rc = _test_only(job_ptr, node_bitmap, min_nodes,
 				max_nodes, req_nodes, job_node_req);
 	} else if (mode == SELECT_MODE_RUN_NOW) {
+		/*
+		 * Switch requirements are relaxed as the job waits, and
+		 * reservation cores and preemptable jobs are not part of the
+		 * cache key, so only tests without them are cached.
+		 */
+		bool use_cache = !job_ptr->req_switch && !exc_cores &&
+				 (!preemptee_candidates ||
+				  !list_count(preemptee_candidates));
+		bitstr_t *orig_map = NULL;
+		uint64_t key = 0;
+
+		if (use_cache) {
+			key = _feas_cache_key(job_ptr, node_bitmap, min_nodes,
+					      max_nodes, req_nodes,
+					      job_node_req);
+			if ((rc = _feas_cache_lookup(job_ptr, node_bitmap,
+						     key)))
+				return rc;
+			orig_map = bit_copy(node_bitmap);
+		}
 		rc = _run_now(job_ptr, node_bitmap, min_nodes, max_nodes,
 			      req_nodes, job_node_req,
 			      preemptee_candidates,
 			      preemptee_job_list, exc_cores);
+		if (use_cache && (rc != SLURM_SUCCESS))
+			_feas_cache_store(job_ptr, orig_map, key, rc);
+		FREE_NULL_BITMAP(orig_map);
 	} else {
 		/* Should never get here */
 		error("Mode %d is invalid",
@@ -82,4 +82,7 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *bitmap,
 			   List *preemptee_job_list,
 			   bitstr_t **exc_cores);
 
+/* Release the cache of failed job tests */
+extern void common_job_test_fini(void);
+
 #endif /* _CONS_COMMON_JOB_TEST */
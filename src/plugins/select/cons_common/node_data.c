@@ -49,7 +49,8 @@ extern void node_data_destroy(node_use_record_t *node_usage,
 	xfree(node_data);
 	if (node_usage) {
 		for (i = 0; i < select_node_cnt; i++) {
-			FREE_NULL_LIST(node_usage[i].gres_list);
+			if (!node_usage[i].gres_list_shared)
+				FREE_NULL_LIST(node_usage[i].gres_list);
 		}
 		xfree(node_usage);
 	}
@@ -90,12 +91,18 @@ extern void node_data_dump(void)
 	}
 }
 
-/* Create a duplicate node_use_record list */
+/*
+ * Create a duplicate node_use_record list
+ *
+ * Copying every node's GRES list dominated the cost of will-run and
+ * preemption tests, while only the nodes of the jobs removed in the
+ * simulation are ever modified. The lists are shared with orig_ptr here and
+ * copied on first write by node_data_own_gres().
+ */
 extern node_use_record_t *node_data_dup_use(
 	node_use_record_t *orig_ptr, bitstr_t *node_map)
 {
 	node_use_record_t *new_use_ptr, *new_ptr;
-	List gres_list;
 	int i, i_first, i_last;
 
 	if (orig_ptr == NULL)
@@ -121,10 +128,22 @@ extern node_use_record_t *node_data_dup_use(
 		new_ptr[i].node_state   = orig_ptr[i].node_state;
 		new_ptr[i].alloc_memory = orig_ptr[i].alloc_memory;
 		if (orig_ptr[i].gres_list)
-			gres_list = orig_ptr[i].gres_list;
+			new_ptr[i].gres_list = orig_ptr[i].gres_list;
 		else
-			gres_list = node_record_table_ptr[i].gres_list;
-		new_ptr[i].gres_list = gres_node_state_dup(gres_list);
+			new_ptr[i].gres_list =
+				node_record_table_ptr[i].gres_list;
+		new_ptr[i].gres_list_shared = true;
 	}
 	return new_use_ptr;
 }
+
+extern void node_data_own_gres(node_use_record_t *node_usage, int node_inx)
+{
+	node_use_record_t *use_ptr = &node_usage[node_inx];
+
+	if (!use_ptr->gres_list_shared)
+		return;
+
+	use_ptr->gres_list = gres_node_state_dup(use_ptr->gres_list);
+	use_ptr->gres_list_shared = false;
+}
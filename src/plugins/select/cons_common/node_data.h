@@ -67,6 +67,9 @@ typedef struct {
 				       * defined in in src/common/gres.h.
 				       * Local data used only in state copy
 				       * to emulate future node state */
+	bool gres_list_shared;	      /* gres_list belongs to the record this
+				       * one was duplicated from, copy it with
+				       * node_data_own_gres() before writing */
 	uint16_t node_state;	      /* see node_cr_state comments */
 } node_use_record_t;
 
@@ -79,7 +82,18 @@ extern void node_data_destroy(node_use_record_t *node_usage,
 
 extern void node_data_dump(void);
 
+/*
+ * Create a duplicate node_use_record list
+ * NOTE: GRES state is shared with orig_ptr until node_data_own_gres() is
+ * called on a node, so orig_ptr must not change while the duplicate is in use.
+ */
 extern node_use_record_t *node_data_dup_use(node_use_record_t *orig_ptr,
 					    bitstr_t *node_map);
 
+/*
+ * Give node node_inx of a duplicated node_use_record list its own copy of
+ * the GRES state before modifying it
+ */
+extern void node_data_own_gres(node_use_record_t *node_usage, int node_inx);
+
 #endif /*_CONS_COMMON_NODE_DATA_H */
@@ -324,6 +324,7 @@ extern void part_data_create_array(void)
 
 	part_data_destroy_res(select_part_record);
 	select_part_record = NULL;
+	select_state_gen++;
 
 	num_parts = list_count(part_list);
 	if (!num_parts)
@@ -371,10 +372,9 @@ extern void part_data_destroy_res(part_res_record_t *this_ptr)
 		this_ptr = this_ptr->next;
 		tmp->part_ptr = NULL;
 
-		if (tmp->row) {
+		if (tmp->row && !tmp->row_shared)
 			part_data_destroy_row(tmp->row, tmp->num_rows);
-			tmp->row = NULL;
-		}
+		tmp->row = NULL;
 		xfree(tmp);
 	}
 }
@@ -431,7 +431,13 @@ extern void part_data_dump_res(part_res_record_t *p_ptr)
 	}
 }
 
-/* Create a duplicate part_res_record list */
+/*
+ * Create a duplicate part_res_record list
+ *
+ * Most simulated job removals only touch a few partitions, so the row arrays
+ * are shared with orig_ptr here and copied on first write by
+ * part_data_own_rows().
+ */
 extern part_res_record_t *part_data_dup_res(
 	part_res_record_t *orig_ptr, bitstr_t *node_map)
 {
@@ -449,8 +455,8 @@ extern part_res_record_t *part_data_dup_res(
 		    bit_overlap_any(node_map,
 				    orig_ptr->part_ptr->node_bitmap)) {
 			new_ptr->num_rows = orig_ptr->num_rows;
-			new_ptr->row = part_data_dup_row(orig_ptr->row,
-							 orig_ptr->num_rows);
+			new_ptr->row = orig_ptr->row;
+			new_ptr->row_shared = true;
 		}
 		if (orig_ptr->next) {
 			new_ptr->next = xmalloc(sizeof(part_res_record_t));
@@ -461,7 +467,19 @@ extern part_res_record_t *part_data_dup_res(
 	return new_part_ptr;
 }
 
-/* sort the rows of a partition from "most allocated" to "least allocated" */
+extern void part_data_own_rows(part_res_record_t *p_ptr)
+{
+	if (!p_ptr->row_shared)
+		return;
+
+	p_ptr->row = part_data_dup_row(p_ptr->row, p_ptr->num_rows);
+	p_ptr->row_shared = false;
+}
+
+/*
+ * sort the rows of a partition from "most allocated" to "least allocated"
+ * Shared rows are only copied if their order actually changes.
+ */
 extern void part_data_sort_res(part_res_record_t *p_ptr)
 {
 	uint32_t i, j;
@@ -473,6 +491,7 @@ extern void part_data_sort_res(part_res_record_t *p_ptr)
 		for (j = i + 1; j < p_ptr->num_rows; j++) {
 			if (p_ptr->row[j].row_set_count >
 			    p_ptr->row[i].row_set_count) {
+				part_data_own_rows(p_ptr);
 				_swap_rows(&(p_ptr->row[i]), &(p_ptr->row[j]));
 			}
 		}
@@ -58,6 +58,9 @@ typedef struct part_res_record {
 	uint16_t num_rows;	      /* Number of elements in "row" array */
 	part_record_t *part_ptr; /* controller part record pointer */
 	part_row_data_t *row;    /* array of rows containing jobs */
+	bool row_shared;	      /* "row" belongs to the record this one
+				       * was duplicated from, copy it with
+				       * part_data_own_rows() before writing */
 } part_res_record_t;
 
 extern part_res_record_t *select_part_record;
@@ -92,10 +95,17 @@ extern void part_data_destroy_row(part_row_data_t *row, uint16_t num_rows);
 /* Log contents of partition structure */
 extern void part_data_dump_res(part_res_record_t *p_ptr);
 
-/* Create a duplicate part_res_record list */
+/*
+ * Create a duplicate part_res_record list
+ * NOTE: The rows are shared with orig_ptr until part_data_own_rows() is called
+ * on a record, so orig_ptr must not change while the duplicate is in use.
+ */
 extern part_res_record_t *part_data_dup_res(
 	part_res_record_t *orig_ptr, bitstr_t *node_map);
 
+/* Give a duplicated record its own copy of the rows before modifying them */
+extern void part_data_own_rows(part_res_record_t *p_ptr);
+
 /* sort the rows of a partition from "most allocated" to "least allocated" */
 extern void part_data_sort_res(part_res_record_t *p_ptr);
 
@@ -182,8 +182,16 @@ _load_job_records (void)
 	/* We need the fill job array string representation for identifying
 	 * and killing job arrays */
 	setenv("SLURM_BITSTR_LEN", "0", 1);
-	error_code = slurm_load_jobs ((time_t) NULL, &job_buffer_ptr,
-				      SHOW_ALL | SHOW_FEDERATION);
+	/*
+	 * Jobs of other users would be filtered out anyway, unless job IDs
+	 * were given which must then be verified against all jobs.
+	 */
+	if (opt.user_name && !opt.job_cnt)
+		error_code = slurm_load_job_user(&job_buffer_ptr, opt.user_id,
+						 SHOW_ALL);
+	else
+		error_code = slurm_load_jobs((time_t) NULL, &job_buffer_ptr,
+					     SHOW_ALL | SHOW_FEDERATION);
 
 	if (error_code) {
 		slurm_perror ("slurm_load_jobs error");
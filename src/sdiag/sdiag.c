@@ -147,6 +147,8 @@ static int _print_stats(void)
 		       ((buf->req_time - buf->req_time_start) / 60)));
 	}
 	printf("\tLast queue length: %u\n", buf->schedule_queue_len);
+	printf("\tSelect cache hits:   %u\n", buf->select_cache_hits);
+	printf("\tSelect cache misses: %u\n", buf->select_cache_misses);
 
 	if (buf->bf_active) {
 		printf("\nBackfilling stats (WARNING: data obtained"
@@ -192,6 +194,32 @@ static int _print_stats(void)
 		printf("\tMean table size: %u\n",
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
+	printf("\tTable slices copied: %u\n", buf->bf_slice_copied);
+	printf("\tTable slices reused: %u\n", buf->bf_slice_reused);
+
+	printf("\nPriority decay statistics (microseconds):\n");
+	printf("\tLast cycle:   %u\n", buf->decay_cycle_last);
+	printf("\tMax cycle:    %u\n", buf->decay_cycle_max);
+	printf("\tTotal cycles: %u\n", buf->decay_cycle_counter);
+	if (buf->decay_cycle_counter > 0) {
+		printf("\tMean cycle:   %"PRIu64"\n",
+		       buf->decay_cycle_sum / buf->decay_cycle_counter);
+	}
+
+	if (buf->fwd_timeout_hist_cnt) {
+		static const char *fwd_bucket[] = {
+			"<10%", "10-25%", "25-50%", "50-100%", "timed out"
+		};
+
+		printf("\nMessage forwarding statistics:\n");
+		for (i = 0; i < buf->fwd_timeout_hist_cnt; i++) {
+			printf("\tTimeout used %-10s %u\n",
+			       (i < ARRAY_SIZE(fwd_bucket)) ?
+			       fwd_bucket[i] : "?",
+			       buf->fwd_timeout_hist[i]);
+		}
+		printf("\tSlow heads replaced:    %u\n", buf->fwd_reordered);
+	}
 
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
@@ -220,6 +248,11 @@ static int _print_stats(void)
 	}
 
 	printf("\nPending RPC statistics\n");
+	printf("\tAgent pool threads:   %u\n", buf->agent_pool_size);
+	printf("\tAgent pool busy:      %u\n", buf->agent_pool_busy);
+	printf("\tAgent pool queued:    %u\n", buf->agent_pool_queued);
+	printf("\tAgent RPCs started:   %u\n", buf->agent_rpcs_started);
+	printf("\tKill RPCs coalesced:  %u\n", buf->agent_msgs_coalesced);
 	if (buf->rpc_queue_type_count == 0)
 		printf("\tNo pending RPCs\n");
 	for (i = 0; i < buf->rpc_queue_type_count; i++){
@@ -105,6 +105,9 @@
 #define RPC_PACK_MAX_AGE	30	/* Rebuild data over 30 seconds old */
 #define DUMP_RPC_COUNT 		25
 #define HOSTLIST_MAX_SIZE 	80
+#define KILL_COALESCE_MAX	100	/* kill RPCs merged per node set */
+/* Most agents that can run at once, one node each, see agent() */
+#define AGENT_POOL_MAX		(MAX_SERVER_THREADS / 3)
 
 typedef enum {
 	DSH_NEW,        /* Request not yet started */
@@ -167,6 +170,8 @@ typedef struct queued_request {
 	time_t       first_attempt;	/* Time of first check for batch
 					 * launch RPC *only* */
 	time_t       last_attempt;	/* Time of last xmit attempt */
+	char        *hostlist_str;	/* Ranged hostlist, set when first
+					 * considered for coalescing */
 } queued_request_t;
 
 typedef struct mail_info {
@@ -175,7 +180,9 @@ typedef struct mail_info {
 } mail_info_t;
 
 static void _agent_defer(void);
-static void _agent_retry(int min_wait, bool wait_too);
+static bool _agent_retry(int min_wait, bool wait_too);
+static void _agent_pool_run(agent_arg_t *agent_arg_ptr);
+static void _coalesce_kill_requests(queued_request_t *queued_req_ptr);
 static int  _batch_launch_defer(queued_request_t *queued_req_ptr);
 static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr);
 static int  _signal_defer(queued_request_t *queued_req_ptr);
@@ -191,6 +198,7 @@ static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
 static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			   int *count, int *spot);
 static void _sig_handler(int dummy);
+static int  _sign_batch_cred(agent_arg_t *agent_arg_ptr);
 static void *_thread_per_group_rpc(void *args);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
@@ -232,6 +240,19 @@ static uint32_t *rpc_type_list;
 static char **rpc_host_list = NULL;
 static time_t cache_build_time = 0;
 
+/*
+ * Persistent agent worker threads. Requests taken off retry_list are handed
+ * to an idle worker instead of a newly created thread. The pool grows on
+ * demand up to AGENT_POOL_MAX and workers only exit at shutdown.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_cond  = PTHREAD_COND_INITIALIZER;
+static List pool_work_list = NULL;	/* agent_arg_t waiting for a worker */
+static int pool_workers = 0;
+static int pool_busy = 0;
+static uint32_t pool_rpcs_dispatched = 0;
+static uint32_t pool_msgs_coalesced = 0; /* protected by retry_mutex */
+
 /*
  * agent - party responsible for transmitting an common RPC in parallel
  *	across a set of nodes. Use agent_queue_request() if immediate
@@ -305,6 +326,10 @@ void *agent(void *args)
 		goto cleanup;
 	}
 
+	if ((agent_arg_ptr->msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
+	    _sign_batch_cred(agent_arg_ptr))
+		goto cleanup;
+
 	/* initialize the agent data structures */
 	agent_info_ptr = _make_agent_info(agent_arg_ptr);
 	thread_ptr = agent_info_ptr->thread_struct;
@@ -1358,9 +1383,71 @@ static void _list_delete_retry(void *retry_entry)
 
 	queued_req_ptr = (queued_request_t *) retry_entry;
 	_purge_agent_args(queued_req_ptr->agent_arg_ptr);
+	xfree(queued_req_ptr->hostlist_str);
 	xfree(queued_req_ptr);
 }
 
+static void _list_delete_agent_arg(void *x)
+{
+	_purge_agent_args(x);
+}
+
+/* Persistent worker, runs agent() for each request handed to the pool */
+static void *_agent_worker(void *arg)
+{
+	agent_arg_t *agent_arg_ptr;
+	struct timespec ts = {0, 0};
+
+	slurm_mutex_lock(&pool_mutex);
+	while (!slurmctld_config.shutdown_time) {
+		if (!(agent_arg_ptr = list_dequeue(pool_work_list))) {
+			ts.tv_sec = time(NULL) + 2;
+			slurm_cond_timedwait(&pool_cond, &pool_mutex, &ts);
+			continue;
+		}
+		pool_busy++;
+		slurm_mutex_unlock(&pool_mutex);
+
+		agent(agent_arg_ptr);
+
+		slurm_mutex_lock(&pool_mutex);
+		pool_busy--;
+	}
+	pool_workers--;
+	slurm_mutex_unlock(&pool_mutex);
+
+	return NULL;
+}
+
+/* Hand a request to an idle worker, adding a worker if none is idle */
+static void _agent_pool_run(agent_arg_t *agent_arg_ptr)
+{
+	slurm_mutex_lock(&pool_mutex);
+	if (!pool_work_list)
+		pool_work_list = list_create(_list_delete_agent_arg);
+	list_enqueue(pool_work_list, agent_arg_ptr);
+	pool_rpcs_dispatched++;
+	if (((pool_busy + list_count(pool_work_list)) > pool_workers) &&
+	    (pool_workers < AGENT_POOL_MAX)) {
+		pool_workers++;
+		slurm_thread_create_detached(NULL, _agent_worker, NULL);
+	}
+	slurm_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+}
+
+static int _agent_pool_queued(void)
+{
+	int cnt = 0;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (pool_work_list)
+		cnt = list_count(pool_work_list);
+	slurm_mutex_unlock(&pool_mutex);
+
+	return cnt;
+}
+
 /* Start a thread to manage queued agent requests */
 static void *_agent_init(void *arg)
 {
@@ -1392,12 +1479,19 @@ static void *_agent_init(void *arg)
 			_agent_defer();
 		}
 
-		_agent_retry(min_wait, mail_too);
+		/* Start as many queued requests as there is room for */
+		while (_agent_retry(min_wait, mail_too))
+			;
 	}
 
 	slurm_mutex_lock(&pending_mutex);
 	pending_thread_running = false;
 	slurm_mutex_unlock(&pending_mutex);
+
+	/* Wake idle workers so they notice the shutdown */
+	slurm_mutex_lock(&pool_mutex);
+	slurm_cond_broadcast(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
 	return NULL;
 }
 
@@ -1440,7 +1534,8 @@ extern void agent_trigger(int min_wait, bool mail_too)
 }
 
 /* agent_pack_pending_rpc_stats - pack counts of pending RPCs into a buffer */
-extern void agent_pack_pending_rpc_stats(buf_t *buffer)
+extern void agent_pack_pending_rpc_stats(buf_t *buffer,
+					 uint16_t protocol_version)
 {
 	time_t now;
 	int i;
@@ -1509,6 +1604,32 @@ pack_it:
 
 	pack32_array(rpc_type_list, rpc_count, buffer);
 	packstr_array(rpc_host_list, rpc_count, buffer);
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		/* Not cached, these are cheap to collect */
+		slurm_mutex_lock(&retry_mutex);
+		pack32(pool_msgs_coalesced, buffer);
+		slurm_mutex_unlock(&retry_mutex);
+
+		slurm_mutex_lock(&pool_mutex);
+		pack32(pool_workers, buffer);
+		pack32(pool_busy, buffer);
+		pack32(pool_work_list ? list_count(pool_work_list) : 0, buffer);
+		pack32(pool_rpcs_dispatched, buffer);
+		slurm_mutex_unlock(&pool_mutex);
+	}
+}
+
+/* agent_reset_stats - clear the agent throughput counters */
+extern void agent_reset_stats(void)
+{
+	slurm_mutex_lock(&retry_mutex);
+	pool_msgs_coalesced = 0;
+	slurm_mutex_unlock(&retry_mutex);
+
+	slurm_mutex_lock(&pool_mutex);
+	pool_rpcs_dispatched = 0;
+	slurm_mutex_unlock(&pool_mutex);
 }
 
 static void _agent_defer(void)
@@ -1569,14 +1690,16 @@ static void _agent_defer(void)
 }
 
 /* Do the work requested by agent_retry (retry pending RPCs).
- * This is a separate thread so the job records can be locked */
-static void _agent_retry(int min_wait, bool mail_too)
+ * This is a separate thread so the job records can be locked
+ * RET true if a request was started and there may be room for another */
+static bool _agent_retry(int min_wait, bool mail_too)
 {
 	time_t now = time(NULL);
 	queued_request_t *queued_req_ptr = NULL;
 	agent_arg_t *agent_arg_ptr = NULL;
 	ListIterator retry_iter;
 	mail_info_t *mi = NULL;
+	int pool_queued = _agent_pool_queued();
 
 	slurm_mutex_lock(&retry_mutex);
 	if (retry_list) {
@@ -1606,12 +1729,17 @@ static void _agent_retry(int min_wait, bool mail_too)
 		}
 	}
 
+	/*
+	 * Requests handed to the worker pool but not yet started by a worker
+	 * have not been counted in agent_thread_cnt, reserve room for them.
+	 */
 	slurm_mutex_lock(&agent_cnt_mutex);
-	if (agent_thread_cnt + AGENT_THREAD_COUNT + 2 > MAX_SERVER_THREADS) {
+	if (agent_thread_cnt + ((pool_queued + 1) * (AGENT_THREAD_COUNT + 2)) >
+	    MAX_SERVER_THREADS) {
 		/* too much work already */
 		slurm_mutex_unlock(&agent_cnt_mutex);
 		slurm_mutex_unlock(&retry_mutex);
-		return;
+		return false;
 	}
 	slurm_mutex_unlock(&agent_cnt_mutex);
 
@@ -1625,6 +1753,8 @@ static void _agent_retry(int min_wait, bool mail_too)
 			}
 		}
 		list_iterator_destroy(retry_iter);
+		if (queued_req_ptr)
+			_coalesce_kill_requests(queued_req_ptr);
 	}
 
 	if (retry_list && (queued_req_ptr == NULL)) {
@@ -1647,13 +1777,15 @@ static void _agent_retry(int min_wait, bool mail_too)
 
 	if (queued_req_ptr) {
 		agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
+		xfree(queued_req_ptr->hostlist_str);
 		xfree(queued_req_ptr);
 		if (agent_arg_ptr) {
-			debug2("Spawning RPC agent for msg_type %s",
+			debug2("Starting RPC agent for msg_type %s",
 			       rpc_num2string(agent_arg_ptr->msg_type));
-			slurm_thread_create_detached(NULL, agent, agent_arg_ptr);
+			_agent_pool_run(agent_arg_ptr);
 		} else
 			error("agent_retry found record with no agent_args");
+		return true;
 	} else if (mail_too) {
 		slurm_mutex_lock(&agent_cnt_mutex);
 		slurm_mutex_lock(&mail_mutex);
@@ -1671,7 +1803,95 @@ static void _agent_retry(int min_wait, bool mail_too)
 		slurm_mutex_unlock(&agent_cnt_mutex);
 	}
 
-	return;
+	return false;
+}
+
+static bool _kill_coalescable(agent_arg_t *agent_arg_ptr)
+{
+	if ((agent_arg_ptr->msg_type != REQUEST_TERMINATE_JOB) &&
+	    (agent_arg_ptr->msg_type != REQUEST_KILL_TIMELIMIT) &&
+	    (agent_arg_ptr->msg_type != REQUEST_KILL_PREEMPTED))
+		return false;
+	if (agent_arg_ptr->addr || !agent_arg_ptr->msg_args)
+		return false;
+	/* Zero means the current protocol version */
+	if (agent_arg_ptr->protocol_version &&
+	    (agent_arg_ptr->protocol_version < SLURM_21_08_PROTOCOL_VERSION))
+		return false;
+	return true;
+}
+
+static char *_queued_hostlist_str(queued_request_t *queued_req_ptr)
+{
+	if (!queued_req_ptr->hostlist_str)
+		queued_req_ptr->hostlist_str = hostlist_ranged_string_xmalloc(
+			queued_req_ptr->agent_arg_ptr->hostlist);
+	return queued_req_ptr->hostlist_str;
+}
+
+/*
+ * Merge never attempted kill requests of the same type and for exactly the
+ * same nodes as queued_req_ptr into it, turning it into a single
+ * REQUEST_TERMINATE_JOBS so each node gets one RPC rather than one per job.
+ * Called with retry_mutex locked and queued_req_ptr already removed from
+ * retry_list.
+ */
+static void _coalesce_kill_requests(queued_request_t *queued_req_ptr)
+{
+	agent_arg_t *agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
+	agent_arg_t *other_arg_ptr;
+	queued_request_t *other_req_ptr;
+	terminate_jobs_msg_t *term_msg = NULL;
+	ListIterator retry_iter;
+	char *hostlist_str;
+
+	if (!agent_arg_ptr || !_kill_coalescable(agent_arg_ptr))
+		return;
+
+	hostlist_str = _queued_hostlist_str(queued_req_ptr);
+	retry_iter = list_iterator_create(retry_list);
+	while ((other_req_ptr = list_next(retry_iter))) {
+		other_arg_ptr = other_req_ptr->agent_arg_ptr;
+		if (other_req_ptr->last_attempt || !other_arg_ptr ||
+		    (other_arg_ptr->msg_type != agent_arg_ptr->msg_type) ||
+		    (other_arg_ptr->node_count != agent_arg_ptr->node_count) ||
+		    (other_arg_ptr->retry != agent_arg_ptr->retry) ||
+		    !_kill_coalescable(other_arg_ptr) ||
+		    xstrcmp(_queued_hostlist_str(other_req_ptr), hostlist_str))
+			continue;
+
+		if (!term_msg) {
+			term_msg = xmalloc(sizeof(*term_msg));
+			term_msg->msg_type = agent_arg_ptr->msg_type;
+			term_msg->kill_msgs = xcalloc(KILL_COALESCE_MAX,
+						      sizeof(kill_job_msg_t *));
+			term_msg->kill_msgs[term_msg->job_cnt++] =
+				agent_arg_ptr->msg_args;
+		}
+		term_msg->kill_msgs[term_msg->job_cnt++] =
+			other_arg_ptr->msg_args;
+		other_arg_ptr->msg_args = NULL;
+		if (!agent_arg_ptr->protocol_version ||
+		    (other_arg_ptr->protocol_version &&
+		     (other_arg_ptr->protocol_version <
+		      agent_arg_ptr->protocol_version)))
+			agent_arg_ptr->protocol_version =
+				other_arg_ptr->protocol_version;
+		list_delete_item(retry_iter);
+		if (term_msg->job_cnt >= KILL_COALESCE_MAX)
+			break;
+	}
+	list_iterator_destroy(retry_iter);
+
+	if (!term_msg)
+		return;
+
+	log_flag(AGENT, "%s: coalesced %u %s RPCs to %s",
+		 __func__, term_msg->job_cnt,
+		 rpc_num2string(term_msg->msg_type), hostlist_str);
+	pool_msgs_coalesced += term_msg->job_cnt;
+	agent_arg_ptr->msg_type = REQUEST_TERMINATE_JOBS;
+	agent_arg_ptr->msg_args = term_msg;
 }
 
 /*
@@ -1743,6 +1963,9 @@ extern void agent_purge(void)
 		FREE_NULL_LIST(mail_list);
 		slurm_mutex_unlock(&mail_mutex);
 	}
+	slurm_mutex_lock(&pool_mutex);
+	FREE_NULL_LIST(pool_work_list);
+	slurm_mutex_unlock(&pool_mutex);
 
 	xfree(rpc_stat_counts);
 	xfree(rpc_stat_types);
@@ -1804,6 +2027,8 @@ static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 			 (agent_arg_ptr->msg_type == REQUEST_KILL_PREEMPTED) ||
 			 (agent_arg_ptr->msg_type == REQUEST_KILL_TIMELIMIT))
 			slurm_free_kill_job_msg(agent_arg_ptr->msg_args);
+		else if (agent_arg_ptr->msg_type == REQUEST_TERMINATE_JOBS)
+			slurm_free_terminate_jobs_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == SRUN_USER_MSG)
 			slurm_free_srun_user_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == SRUN_EXEC)
@@ -2100,6 +2325,50 @@ extern void mail_job_info(job_record_t *job_ptr, uint16_t mail_type)
 	return;
 }
 
+/*
+ * Sign the credential of a batch job launch request. launch_job() only
+ * builds the credential so that the user lookups and the signature, which
+ * may need a round trip to munged, are done here without holding the job
+ * write lock. On failure the job is requeued as launch_job() used to do.
+ * RET 0 if the request can be sent, -1 if it must be dropped
+ */
+static int _sign_batch_cred(agent_arg_t *agent_arg_ptr)
+{
+	batch_job_launch_msg_t *launch_msg_ptr = agent_arg_ptr->msg_args;
+	job_record_t *job_ptr;
+	DEF_TIMERS;
+	/* Locks: Write job, write node, read federation */
+	slurmctld_lock_t job_write_lock =
+		{ .job = WRITE_LOCK, .node = WRITE_LOCK, .fed = READ_LOCK };
+
+	if (!launch_msg_ptr->cred ||
+	    slurm_cred_is_signed(launch_msg_ptr->cred))
+		return 0;
+
+	START_TIMER;
+	if (slurm_cred_sign(slurmctld_config.cred_ctx, launch_msg_ptr->cred,
+			    agent_arg_ptr->protocol_version) ==
+	    SLURM_SUCCESS) {
+		END_TIMER2("batch credential signing");
+		return 0;
+	}
+
+	/* See the FIXME in _build_launch_job_msg() */
+	error("Can not sign job credential, attempting to requeue batch JobId=%u",
+	      launch_msg_ptr->job_id);
+	lock_slurmctld(job_write_lock);
+	job_ptr = find_job_record(launch_msg_ptr->job_id);
+	if (job_ptr && IS_JOB_RUNNING(job_ptr)) {
+		job_ptr->batch_flag = 1;	/* Allow repeated requeue */
+		job_ptr->details->begin_time = time(NULL) + 120;
+		job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
+			     true, false, 0);
+	}
+	unlock_slurmctld(job_write_lock);
+
+	return -1;
+}
+
 /* Test if a batch launch request should be defered
  * RET -1: abort the request, pending job cancelled
  *      0: execute the request now
@@ -101,8 +101,15 @@ extern int get_agent_count(void);
 /* get_agent_thread_count - get count of threads spawned by agents */
 extern int get_agent_thread_count(void);
 
-/* agent_pack_pending_rpc_stats - pack counts of pending RPCs into a buffer */
-extern void agent_pack_pending_rpc_stats(buf_t *buffer);
+/*
+ * agent_pack_pending_rpc_stats - pack counts of pending RPCs and agent worker
+ *	pool statistics into a buffer
+ */
+extern void agent_pack_pending_rpc_stats(buf_t *buffer,
+					 uint16_t protocol_version);
+
+/* agent_reset_stats - clear the agent throughput counters */
+extern void agent_reset_stats(void);
 
 /*
  * mail_job_info - Send e-mail notice of job state change
@@ -61,6 +61,7 @@
 #include "src/common/assoc_mgr.h"
 #include "src/common/daemonize.h"
 #include "src/common/fd.h"
+#include "src/common/forward.h"
 #include "src/common/gres.h"
 #include "src/common/group_cache.h"
 #include "src/common/hostlist.h"
@@ -204,6 +205,14 @@ static char *	debug_logfile = NULL;
 static bool	dump_core = false;
 static int      job_sched_cnt = 0;
 static uint32_t max_server_threads = MAX_SERVER_THREADS;
+static pthread_cond_t conn_pool_cond = PTHREAD_COND_INITIALIZER;
+static int	conn_pool_cnt = 0;	/* service threads started */
+static int	conn_pool_idle = 0;	/* service threads waiting for work */
+static pthread_mutex_t conn_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List	conn_pool_queue = NULL;	/* connections ready to service */
+static bool	conn_pool_shutdown = false;
+static uint32_t max_server_conns = MAX_SERVER_THREADS *
+				   MAX_PENDING_CONN_FACTOR;
 static time_t	next_stats_reset = 0;
 static int	new_nice = 0;
 static int	recover   = DEFAULT_RECOVER;
@@ -243,7 +252,9 @@ static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
 static void         _run_primary_prog(bool primary_on);
+static void         _queue_connection(int fd);
 static void *       _service_connection(void *arg);
+static void *       _service_connection_pool(void *no_data);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(void);
 static void *       _slurmctld_background(void *no_data);
@@ -258,7 +269,6 @@ static void         _update_nice(void);
 static void         _update_qos(slurmdb_qos_rec_t *rec);
 inline static void  _usage(char *prog_name);
 static bool         _verify_clustername(void);
-static bool         _wait_for_server_thread(void);
 static void *       _wait_primary_prog(void *arg);
 
 /* main - slurmctld main function, start various threads and process RPCs */
@@ -584,6 +594,7 @@ int main(int argc, char **argv)
 		}
 	}
 	config_power_mgr();
+	forward_adaptive_init();
 	agent_init();
 	if (node_features_g_node_power() && !power_save_test()) {
 		if (test_config) {
@@ -881,6 +892,7 @@ int main(int argc, char **argv)
 
 	/* Purge our local data structures */
 	configless_clear();
+	packed_info_cache_fini();
 	xcgroup_fini_slurm_cgroup_conf();
 	power_save_fini();
 	job_fini();
@@ -907,6 +919,7 @@ int main(int argc, char **argv)
 	slurm_auth_fini();
 	switch_fini();
 	route_fini();
+	forward_adaptive_fini();
 
 	/* purge remaining data structures */
 	group_cache_purge();
@@ -1114,14 +1127,78 @@ static void _sig_handler(int signal)
 }
 
 /*
- * _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each
+ * Queue an accepted connection for the service thread pool, starting
+ * another service thread if none is idle and the pool is not yet full.
+ */
+static void _queue_connection(int fd)
+{
+	int *conn_fd = xmalloc(sizeof(*conn_fd));
+
+	*conn_fd = fd;
+	server_thread_incr();
+
+	slurm_mutex_lock(&conn_pool_mutex);
+	list_enqueue(conn_pool_queue, conn_fd);
+	if (!conn_pool_idle && (conn_pool_cnt < max_server_threads)) {
+		slurm_thread_create_detached(NULL, _service_connection_pool,
+					     NULL);
+		conn_pool_cnt++;
+	} else {
+		slurm_cond_signal(&conn_pool_cond);
+	}
+	slurm_mutex_unlock(&conn_pool_mutex);
+}
+
+/*
+ * _service_connection_pool - service queued connections until the RPC
+ *	manager shuts down the pool and the queue is empty
+ */
+static void *_service_connection_pool(void *no_data)
+{
+	int *conn_fd;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "srvcn");
+	}
+#endif
+
+	while (true) {
+		slurm_mutex_lock(&conn_pool_mutex);
+		while (!(conn_fd = list_dequeue(conn_pool_queue)) &&
+		       !conn_pool_shutdown) {
+			conn_pool_idle++;
+			slurm_cond_wait(&conn_pool_cond, &conn_pool_mutex);
+			conn_pool_idle--;
+		}
+		if (!conn_fd)
+			conn_pool_cnt--;
+		slurm_mutex_unlock(&conn_pool_mutex);
+
+		if (!conn_fd)
+			break;
+		_service_connection(conn_fd);
+	}
+
+	return NULL;
+}
+
+/*
+ * _slurmctld_rpc_mgr - Accept incoming connections and hand them to the
+ *	service thread pool once the client has sent its request.
+ *
+ * Connections that have been accepted but have not sent anything yet are
+ * watched here instead of tying up a service thread. New connections are
+ * only accepted while fewer than max_server_conns are in progress, beyond
+ * that they are left in the listen backlog.
  */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
-	int *newsockfd;
 	struct pollfd *fds;
+	time_t *accept_times, now;
 	slurm_addr_t cli_addr, srv_addr;
-	int fd_next = 0, i, nports;
+	int fd_cnt, fd_next = 0, i, j, nports, newsockfd;
+	bool saturated;
 	/* Locks: Read config */
 	slurmctld_lock_t config_read_lock = {
 		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
@@ -1144,7 +1221,8 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		fatal("slurmctld port count is zero");
 		return NULL;	/* Fix CLANG false positive */
 	}
-	fds = xcalloc(nports, sizeof(struct pollfd));
+	fds = xcalloc(nports + max_server_conns, sizeof(struct pollfd));
+	accept_times = xcalloc(nports + max_server_conns, sizeof(time_t));
 	for (i = 0; i < nports; i++) {
 		fds[i].fd = slurm_init_msg_engine_port(
 			slurm_conf.slurmctld_port + i);
@@ -1161,11 +1239,19 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		}
 	}
 	unlock_slurmctld(config_read_lock);
+	fd_cnt = nports;
 
 	rpc_queue_init();
 
+	/* Service threads of a previous instance may still be draining */
+	slurm_mutex_lock(&conn_pool_mutex);
+	if (!conn_pool_queue)
+		conn_pool_queue = list_create(xfree_ptr);
+	conn_pool_shutdown = false;
+	slurm_mutex_unlock(&conn_pool_mutex);
+
 	/*
-	 * Prepare to catch SIGUSR1 to interrupt accept().
+	 * Prepare to catch SIGUSR1 to interrupt poll().
 	 * This signal is generated by the slurmctld signal
 	 * handler thread upon receipt of SIGABRT, SIGINT,
 	 * or SIGTERM. That thread does all processing of
@@ -1177,50 +1263,96 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	/*
 	 * Process incoming RPCs until told to shutdown
 	 */
-	while (_wait_for_server_thread()) {
-		if (poll(fds, nports, -1) == -1) {
+	while (!slurmctld_config.shutdown_time) {
+		/* Leave new connections in the backlog when saturated */
+		saturated = ((slurmctld_config.server_thread_count +
+			      fd_cnt - nports) >= max_server_conns);
+		for (i = 0; i < nports; i++)
+			fds[i].events = saturated ? 0 : POLLIN;
+
+		/*
+		 * Wake up periodically to expire idle connections and to
+		 * resume accepting once service threads catch up.
+		 */
+		if (poll(fds, fd_cnt, saturated ? 100 :
+			 (fd_cnt > nports) ? 1000 : -1) == -1) {
 			if (errno != EINTR)
 				error("slurm_accept_msg_conn poll: %m");
-			server_thread_decr();
 			continue;
 		}
+		now = time(NULL);
 
-		/* find one to process */
-		for (i = 0; i < nports; i++) {
-			if (fds[(fd_next + i) % nports].revents) {
-				i = (fd_next + i) % nports;
-				break;
+		/* Hand connections with a request to the service threads */
+		for (i = nports; i < fd_cnt;) {
+			if (fds[i].revents) {
+				_queue_connection(fds[i].fd);
+			} else if ((now - accept_times[i]) >
+				   slurm_conf.msg_timeout) {
+				(void) slurm_get_peer_addr(fds[i].fd,
+							   &cli_addr);
+				error("%s: closing connection from %pA idle for more than %u seconds",
+				      __func__, &cli_addr,
+				      slurm_conf.msg_timeout);
+				close(fds[i].fd);
+			} else {
+				i++;
+				continue;
 			}
+			/* Fill the hole with the last entry */
+			fd_cnt--;
+			fds[i] = fds[fd_cnt];
+			accept_times[i] = accept_times[fd_cnt];
 		}
-		fd_next = (i + 1) % nports;
 
-		newsockfd = xmalloc(sizeof(*newsockfd));
-		if ((*newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
-		    == SLURM_ERROR) {
-			if (errno != EINTR)
-				error("slurm_accept_msg_conn: %m");
-			server_thread_decr();
-			xfree(newsockfd);
-			continue;
-		}
-		fd_set_close_on_exec(*newsockfd);
+		/* Accept new connections, one per port, round-robin */
+		for (j = 0; j < nports; j++) {
+			i = (fd_next + j) % nports;
+			if (saturated || !fds[i].revents ||
+			    (fd_cnt >= (nports + max_server_conns)))
+				continue;
 
-		log_flag(PROTOCOL, "%s: accept() connection from %pA",
-			 __func__, &cli_addr);
+			if ((newsockfd = slurm_accept_msg_conn(fds[i].fd,
+							       &cli_addr)) ==
+			    SLURM_ERROR) {
+				if (errno != EINTR)
+					error("slurm_accept_msg_conn: %m");
+				continue;
+			}
+			fd_set_close_on_exec(newsockfd);
 
-		if (slurmctld_config.shutdown_time) {
-			slurmctld_diag_stats.proc_req_raw++;
-			_service_connection(newsockfd);
-		} else {
-			slurm_thread_create_detached(NULL, _service_connection,
-						     newsockfd);
+			log_flag(PROTOCOL, "%s: accept() connection from %pA",
+				 __func__, &cli_addr);
+
+			if (slurmctld_config.shutdown_time) {
+				int *conn_fd = xmalloc(sizeof(*conn_fd));
+
+				*conn_fd = newsockfd;
+				slurmctld_diag_stats.proc_req_raw++;
+				server_thread_incr();
+				_service_connection(conn_fd);
+				continue;
+			}
+
+			fds[fd_cnt].fd = newsockfd;
+			fds[fd_cnt].events = POLLIN;
+			fds[fd_cnt].revents = 0;
+			accept_times[fd_cnt] = now;
+			fd_cnt++;
 		}
+		fd_next = (fd_next + 1) % nports;
 	}
 
 	debug3("%s shutting down", __func__);
-	for (i = 0; i < nports; i++)
+	for (i = 0; i < fd_cnt; i++)
 		close(fds[i].fd);
 	xfree(fds);
+	xfree(accept_times);
+
+	/* Let the service threads exit once the queue is drained */
+	slurm_mutex_lock(&conn_pool_mutex);
+	conn_pool_shutdown = true;
+	slurm_cond_broadcast(&conn_pool_cond);
+	slurm_mutex_unlock(&conn_pool_mutex);
 
 	rpc_queue_shutdown();
 
@@ -1241,11 +1373,6 @@ static void *_service_connection(void *arg)
 	slurm_msg_t *msg = xmalloc(sizeof *msg);
 	xfree(arg);
 
-#if HAVE_SYS_PRCTL_H
-	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
-		error("%s: cannot set my name to %s %m", __func__, "srvcn");
-	}
-#endif
 	slurm_msg_t_init(msg);
 	msg->flags |= SLURM_MSG_KEEP_BUFFER;
 	/*
@@ -1279,49 +1406,6 @@ cleanup:
 	return NULL;
 }
 
-/* Increment slurmctld_config.server_thread_count and don't return
- * until its value is no larger than MAX_SERVER_THREADS,
- * RET true unless shutdown in progress */
-static bool _wait_for_server_thread(void)
-{
-	bool print_it = true;
-	bool rc = true;
-
-	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
-	while (1) {
-		if (slurmctld_config.shutdown_time) {
-			rc = false;
-			break;
-		}
-		if (slurmctld_config.server_thread_count < max_server_threads) {
-			slurmctld_config.server_thread_count++;
-			break;
-		} else {
-			/* wait for state change and retry,
-			 * just a delay and not an error.
-			 * This can happen when the epilog completes
-			 * on a bunch of nodes at the same time, which
-			 * can easily happen for highly parallel jobs. */
-			if (print_it) {
-				static time_t last_print_time = 0;
-				time_t now = time(NULL);
-				if (difftime(now, last_print_time) > 2) {
-					verbose("server_thread_count over "
-						"limit (%d), waiting",
-						slurmctld_config.
-						server_thread_count);
-					last_print_time = now;
-				}
-				print_it = false;
-			}
-			slurm_cond_wait(&slurmctld_config.thread_count_cond,
-					&slurmctld_config.thread_count_lock);
-		}
-	}
-	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
-	return rc;
-}
-
 /* Decrement slurmctld thread count (as applies to thread limit) */
 extern void server_thread_decr(void)
 {
@@ -3297,14 +3381,23 @@ static void _test_thread_limit(void)
 #ifdef RLIMIT_NOFILE
 {
 	struct rlimit rlim[1];
-	if (getrlimit(RLIMIT_NOFILE, rlim) < 0)
+	if (getrlimit(RLIMIT_NOFILE, rlim) < 0) {
 		error("Unable to get file count limit");
-	else if ((rlim->rlim_cur != RLIM_INFINITY) &&
-		 (max_server_threads > rlim->rlim_cur)) {
+		return;
+	}
+	if ((rlim->rlim_cur != RLIM_INFINITY) &&
+	    (max_server_threads > rlim->rlim_cur)) {
 		max_server_threads = rlim->rlim_cur;
 		info("Reducing max_server_thread to %u due to file count limit "
 		     "of %u", max_server_threads, max_server_threads);
 	}
+	/* Leave room for state files, sockets to slurmd, etc. */
+	if ((rlim->rlim_cur != RLIM_INFINITY) &&
+	    (max_server_conns > (rlim->rlim_cur / 2))) {
+		max_server_conns = MAX(rlim->rlim_cur / 2, max_server_threads);
+		info("Reducing max_server_conns to %u due to file count limit "
+		     "of %u", max_server_conns, (uint32_t) rlim->rlim_cur);
+	}
 }
 #endif
 	return;
@@ -263,7 +263,8 @@ extern void crontab_submit(crontab_update_request_msg_t *request,
 			list_for_each(args.new_jobs, _set_requeue_cron, &off);
 
 		/* on success, kill/modify old jobs */
-		list_for_each(job_list, _clear_requeue_cron, &request->uid);
+		foreach_user_job(request->uid, _clear_requeue_cron,
+				 &request->uid);
 
 		/*
 		 * Flip the flag on now that the old ones have been removed.
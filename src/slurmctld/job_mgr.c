@@ -120,8 +120,22 @@
 #define JOB_ARRAY_HASH_INX(_job_id, _task_id) \
 	((_job_id + _task_id) % hash_table_size)
 
+#define JOB_INDEX_MIN_SLOTS 1024
+
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
+/*
+ * Written instead of JOB_STATE_VERSION since job records are framed as job ID
+ * and record size, job_state files from before that still read unframed.
+ */
+#define JOB_STATE_FRAMED_VERSION "FRAMED_PROTOCOL_VERSION"
+
+/*
+ * Job state journal entries are framed as job ID and record size, a size of
+ * zero marks a purged job. An entry with this job ID holds the
+ * job_id_sequence instead of a job record.
+ */
+#define JOURNAL_ID_SEQUENCE   0
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
 
 typedef enum {
@@ -139,24 +153,76 @@ typedef struct {
 
 typedef struct {
 	buf_t *buffer;
+	time_t    changed_since;
+	bool      delta;
 	uint32_t  filter_uid;
 	uint32_t *jobs_packed;
+	time_t    now;
 	uint16_t  protocol_version;
+	uint32_t  purged_cnt;
+	uint32_t *purged_ids;
 	uint16_t  show_flags;
+	bool      track_changes;
 	uid_t     uid;
 } _foreach_pack_job_info_t;
 
+typedef struct {
+	uint32_t job_id;
+	time_t purge_time;
+} purged_job_t;
+
+typedef struct {
+	uint32_t job_id;
+	bool latest;		/* no later entry for this job */
+	uint32_t offset;	/* of the job record in the journal */
+	uint32_t seq;		/* position in the journal */
+	uint32_t size;		/* of the job record, 0 if purged */
+} journal_entry_t;
+
+typedef struct {
+	buf_t *buffer;
+	uint32_t entry_cnt;
+	journal_entry_t *entries;	/* in journal order */
+	journal_entry_t *sorted;	/* by job_id and seq */
+	uint32_t id_sequence;
+	uint16_t protocol_version;
+} job_state_journal_t;
+
 typedef struct {
 	bitstr_t *node_map;
 	int rc;
 } job_overlap_args_t;
 
+/*
+ * Open addressing (linear probing) index of job records by job ID or user ID.
+ * The key is kept next to the record pointer so that probing never touches
+ * the job records themselves. The slot count is a power of two and at most
+ * half of the slots are in use, so every probe ends at an empty slot.
+ */
+typedef struct {
+	uint32_t key;
+	job_record_t *job_ptr;	/* NULL if the slot is empty */
+} job_index_slot_t;
+
+typedef struct {
+	uint32_t cnt;		/* slots in use */
+	uint32_t mask;		/* slot count - 1 */
+	uint8_t shift;		/* 32 - log2(slot count) */
+	job_index_slot_t *slots;
+} job_index_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
 
 List purge_files_list = NULL;	/* job files to delete */
 
+/*
+ * How long the IDs of purged job records are remembered for SHOW_DELTA
+ * requests. Clients that last updated earlier get a full reply.
+ */
+#define PURGED_JOB_LOG_AGE 600
+
 /* Local variables */
 static int      bf_min_age_reserve = 0;
 static uint32_t delay_boot = 0;
@@ -165,12 +231,30 @@ static uint32_t lowest_prio  = TOP_PRIORITY;
 static int      hash_table_size = 0;
 static int      job_count = 0;		/* job's in the system */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
-static struct   job_record **job_hash = NULL;
+static job_index_t job_id_index;	/* job records by job_id */
+static job_index_t job_user_index;	/* first job record of each user */
 static struct   job_record **job_array_hash_j = NULL;
 static struct   job_record **job_array_hash_t = NULL;
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
+static pthread_mutex_t pack_hash_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List     purged_job_log = NULL;
+static time_t   purged_log_start = (time_t) 0;
+static List     journal_purged_ids = NULL;	/* purged since last save */
+static time_t   journal_ckpt_time = (time_t) 0;	/* job_state journal extends */
+static uint32_t journal_ckpt_size = 0;
+static uint32_t journal_size = 0;
+static uint32_t journal_id_sequence = 0;	/* last saved job_id_sequence */
+/*
+ * job_state_map_mutex is only taken for job details with argv_len set. That
+ * is only set with the job write lock, and cleared under the mutex, so it can
+ * be tested without the mutex first.
+ */
+static pthread_mutex_t job_state_map_mutex = PTHREAD_MUTEX_INITIALIZER;
+static buf_t   *job_state_map = NULL;	/* job_state file with packed argv */
+static uint32_t job_state_map_refs = 0;	/* job details with argv_len set */
+static bool     job_state_map_loading = false;
 static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
 static bool     validate_cfgd_licenses = true;
@@ -192,6 +276,7 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	char *resv_name, slurmdb_assoc_rec_t *assoc_ptr,
 	bool operator, slurmdb_qos_rec_t *qos_rec, int *error_code,
 	bool locked, log_level_t log_lvl);
+static void _drop_packed_argv(struct job_details *detail_ptr);
 static void _dump_job_details(struct job_details *detail_ptr, buf_t *buffer);
 static void _dump_job_state(job_record_t *dump_job_ptr, buf_t *buffer);
 static void _dump_job_fed_details(job_fed_details_t *fed_details_ptr,
@@ -207,6 +292,9 @@ static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 static void _job_timed_out(job_record_t *job_ptr, bool preempted);
 static void _kill_dependent(job_record_t *job_ptr);
 static void _list_delete_job(void *job_entry);
+static void _log_purged_job(uint32_t job_id);
+static uint64_t _hash_buf_data(buf_t *buffer, uint32_t offset);
+static void _journal_purged_job(uint32_t job_id);
 static int  _list_find_job_old(void *job_entry, void *key);
 static int  _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 			      uint16_t protocol_version);
@@ -218,9 +306,11 @@ static uint32_t _max_switch_wait(uint32_t input_wait);
 static void _notify_srun_missing_step(job_record_t *job_ptr, int node_inx,
 				      time_t now, time_t node_boot_time);
 static buf_t *_open_job_state_file(char **state_file);
+static void _release_job_state_map(buf_t *buffer);
 static time_t _get_last_job_state_write_time(void);
 static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 				      uint16_t protocol_version);
+static bool _pack_mapped_argv(struct job_details *detail_ptr, buf_t *buffer);
 static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      buf_t *buffer, uint16_t protocol_version);
 static bool _parse_array_tok(char *tok, bitstr_t *array_bitmap, uint32_t max);
@@ -248,6 +338,8 @@ static void _signal_job(job_record_t *job_ptr, int signal, uint16_t flags);
 static void _suspend_job(job_record_t *job_ptr, uint16_t op, bool indf_susp);
 static int  _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp);
 static bool _top_priority(job_record_t *job_ptr, uint32_t het_job_offset);
+static void _unlink_job_user(job_record_t *job_ptr);
+static void _unref_packed_argv(struct job_details *detail_ptr);
 static int  _valid_job_part(job_desc_msg_t *job_desc, uid_t submit_uid,
 			    bitstr_t *req_bitmap, part_record_t *part_ptr,
 			    List part_ptr_list,
@@ -622,6 +714,51 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 	return job_ptr;
 }
 
+/*
+ * Drop a job's reference to argv packed in the job_state file mapping
+ * NOTE: job_state_map_mutex must be locked
+ */
+static void _unref_packed_argv(struct job_details *detail_ptr)
+{
+	if (!detail_ptr->argv_len)
+		return;
+
+	detail_ptr->argv_len = 0;
+	if (!--job_state_map_refs && !job_state_map_loading) {
+		free_buf(job_state_map);
+		job_state_map = NULL;
+	}
+}
+
+static void _drop_packed_argv(struct job_details *detail_ptr)
+{
+	if (!detail_ptr->argv_len)
+		return;
+
+	slurm_mutex_lock(&job_state_map_mutex);
+	_unref_packed_argv(detail_ptr);
+	slurm_mutex_unlock(&job_state_map_mutex);
+}
+
+/*
+ * Pack argv straight from the job_state file mapping
+ * RET false if argv was unpacked meanwhile
+ */
+static bool _pack_mapped_argv(struct job_details *detail_ptr, buf_t *buffer)
+{
+	bool packed = false;
+
+	slurm_mutex_lock(&job_state_map_mutex);
+	if (detail_ptr->argv_len) {
+		packmem_array(get_buf_data(job_state_map) +
+			      detail_ptr->argv_offset,
+			      detail_ptr->argv_len, buffer);
+		packed = true;
+	}
+	slurm_mutex_unlock(&job_state_map_mutex);
+
+	return packed;
+}
 
 /*
  * _delete_job_details - delete a job's detail record and clear it's pointer
@@ -648,6 +785,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	}
 
 	xfree(job_entry->details->acctg_freq);
+	_drop_packed_argv(job_entry->details);
 	for (i=0; i<job_entry->details->argc; i++)
 		xfree(job_entry->details->argv[i]);
 	xfree(job_entry->details->argv);
@@ -792,10 +930,116 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+/*
+ * Pack a job's state as a journal entry (also used for job_state records).
+ * If only_changed is set, nothing is packed if the job's state is unchanged
+ * since it was last saved.
+ * RET true if the job was packed
+ */
+static bool _dump_job_state_entry(job_record_t *job_ptr, buf_t *buffer,
+				  bool only_changed)
+{
+	uint32_t start, end;
+	uint64_t hash;
+
+	/* Don't pack "unlinked" job. */
+	if (job_ptr->job_id == NO_VAL)
+		return false;
+
+	start = get_buf_offset(buffer);
+	pack32(job_ptr->job_id, buffer);
+	pack32(0, buffer);	/* place holder for record size */
+	_dump_job_state(job_ptr, buffer);
+	end = get_buf_offset(buffer);
+
+	hash = _hash_buf_data(buffer, start + (2 * sizeof(uint32_t)));
+	if (only_changed && (hash == job_ptr->state_hash)) {
+		set_buf_offset(buffer, start);
+		return false;
+	}
+	job_ptr->state_hash = hash;
+
+	set_buf_offset(buffer, start + sizeof(uint32_t));
+	pack32(end - start - (2 * sizeof(uint32_t)), buffer);
+	set_buf_offset(buffer, end);
+
+	return true;
+}
+
+/* Write the buffer's data to the file, RET 0 or errno */
+static int _write_job_state_buf(int fd, buf_t *buffer, char *file)
+{
+	int pos = 0, nwrite, amount;
+	char *data;
+
+	nwrite = get_buf_offset(buffer);
+	data = (char *)get_buf_data(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if ((amount < 0) && (errno != EINTR)) {
+			error("Error writing file %s, %m", file);
+			return errno;
+		}
+		nwrite -= amount;
+		pos    += amount;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Append the records of jobs changed since the last save and the IDs of
+ * purged jobs to the job state journal.
+ */
+static int _append_job_state_journal(buf_t *buffer, time_t now)
+{
+	int error_code = SLURM_SUCCESS, log_fd;
+	char *journal_file;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+
+	lock_state_files();
+	log_fd = open(journal_file, O_CREAT|O_WRONLY|O_APPEND|O_CLOEXEC, 0600);
+	if (log_fd < 0) {
+		error("Can't save state, create file %s error %m",
+		      journal_file);
+		error_code = errno;
+	} else {
+		/* Drop anything left from a previous job_state */
+		if (!journal_size && ftruncate(log_fd, 0)) {
+			error("Can't save state, truncate file %s error %m",
+			      journal_file);
+			error_code = errno;
+		}
+		if (!error_code)
+			error_code = _write_job_state_buf(log_fd, buffer,
+							  journal_file);
+		if (fsync_and_close(log_fd, "job journal") && !error_code)
+			error_code = SLURM_ERROR;
+	}
+	unlock_state_files();
+
+	if (error_code) {
+		/* Journal may be incomplete, write all jobs next time */
+		journal_ckpt_time = (time_t) 0;
+	} else {
+		journal_size += get_buf_offset(buffer);
+	}
+	xfree(journal_file);
+
+	return error_code;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
  *	load_all_job_state().
+ *
+ *	Only jobs whose state changed since the last save and purged job IDs
+ *	are appended to the job_state.journal file. All jobs are written to
+ *	the job_state file, which truncates the journal, once the journal
+ *	has grown larger than the job_state file.
  * RET 0 or error code
  */
 int dump_all_job_state(void)
@@ -803,16 +1047,18 @@ int dump_all_job_state(void)
 	/* Save high-water mark to avoid buffer growth with copies */
 	static int high_buffer_size = (1024 * 1024);
 	int error_code = SLURM_SUCCESS, log_fd;
-	char *old_file, *new_file, *reg_file;
+	char *old_file, *new_file, *reg_file, *journal_file;
 	struct stat stat_buf;
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
-	buf_t *buffer = init_buf(high_buffer_size);
+	buf_t *buffer;
 	time_t now = time(NULL);
 	time_t last_state_file_time;
+	bool journal;
+	uint32_t *purged_id, entry_cnt = 0;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -835,29 +1081,77 @@ int dump_all_job_state(void)
 		}
 	}
 
-	/* write header: version, time */
-	packstr(JOB_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(now, buffer);
-
 	/*
-	 * write header: job id
-	 * This is needed so that the job id remains persistent even after
-	 * slurmctld is restarted.
+	 * Journal entries extend the job_state file written at
+	 * journal_ckpt_time. A new job_state file must be written in a later
+	 * second so that a stale journal is never taken for its own.
 	 */
-	pack32( job_id_sequence, buffer);
+	journal = (journal_ckpt_time &&
+		   ((journal_size <= journal_ckpt_size) ||
+		    (now == journal_ckpt_time)));
+
+	lock_slurmctld(job_read_lock);
+	if (journal) {
+		buffer = init_buf(BUF_SIZE);
+		if (!journal_size) {
+			/* write header: version, time of job_state */
+			packstr(JOB_STATE_FRAMED_VERSION, buffer);
+			pack16(SLURM_PROTOCOL_VERSION, buffer);
+			pack_time(journal_ckpt_time, buffer);
+		}
+
+		/* purged jobs first in case a job ID gets reused */
+		while ((purged_id = list_pop(journal_purged_ids))) {
+			pack32(*purged_id, buffer);
+			pack32(0, buffer);
+			xfree(purged_id);
+			entry_cnt++;
+		}
+		if (job_id_sequence != journal_id_sequence) {
+			pack32(JOURNAL_ID_SEQUENCE, buffer);
+			pack32(sizeof(uint32_t), buffer);
+			pack32(job_id_sequence, buffer);
+			entry_cnt++;
+		}
+	} else {
+		buffer = init_buf(high_buffer_size);
+		list_flush(journal_purged_ids);
+
+		/* write header: version, time */
+		packstr(JOB_STATE_FRAMED_VERSION, buffer);
+		pack16(SLURM_PROTOCOL_VERSION, buffer);
+		pack_time(now, buffer);
+
+		/*
+		 * write header: job id
+		 * This is needed so that the job id remains persistent even
+		 * after slurmctld is restarted.
+		 */
+		pack32( job_id_sequence, buffer);
 
-	debug3("Writing job id %u to header record of job_state file",
-	       job_id_sequence);
+		debug3("Writing job id %u to header record of job_state file",
+		       job_id_sequence);
+	}
+	journal_id_sequence = job_id_sequence;
 
 	/* write individual job records */
-	lock_slurmctld(job_read_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
-		_dump_job_state(job_ptr, buffer);
+		if (_dump_job_state_entry(job_ptr, buffer, journal))
+			entry_cnt++;
 	}
 	list_iterator_destroy(job_iterator);
+	unlock_slurmctld(job_read_lock);
 
+	if (journal) {
+		if (entry_cnt)
+			error_code = _append_job_state_journal(buffer, now);
+		debug3("%s: appended %u entries, %u bytes to journal",
+		       __func__, entry_cnt, get_buf_offset(buffer));
+		free_buf(buffer);
+		END_TIMER2("dump_all_job_state");
+		return error_code;
+	}
 
 	/* write the buffer to file */
 	old_file = xstrdup(slurm_conf.state_save_location);
@@ -866,7 +1160,8 @@ int dump_all_job_state(void)
 	xstrcat(reg_file, "/job_state");
 	new_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(new_file, "/job_state.new");
-	unlock_slurmctld(job_read_lock);
+	journal_file = xstrdup(slurm_conf.state_save_location);
+	xstrcat(journal_file, "/job_state.journal");
 
 	if (stat(reg_file, &stat_buf) == 0) {
 		static time_t last_mtime = (time_t) 0;
@@ -890,30 +1185,20 @@ int dump_all_job_state(void)
 		      new_file);
 		error_code = errno;
 	} else {
-		int pos = 0, nwrite, amount, rc;
-		char *data;
+		int rc;
 
-		nwrite = get_buf_offset(buffer);
-		data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
+		high_buffer_size = MAX(get_buf_offset(buffer),
+				       high_buffer_size);
+		error_code = _write_job_state_buf(log_fd, buffer, new_file);
 
 		rc = fsync_and_close(log_fd, "job");
 		if (rc && !error_code)
 			error_code = rc;
 	}
-	if (error_code)
+	if (error_code) {
 		(void) unlink(new_file);
-	else {			/* file shuffle */
+		journal_ckpt_time = (time_t) 0;
+	} else {			/* file shuffle */
 		(void) unlink(old_file);
 		if (link(reg_file, old_file))
 			debug4("unable to create link for %s -> %s: %m",
@@ -923,11 +1208,17 @@ int dump_all_job_state(void)
 			debug4("unable to create link for %s -> %s: %m",
 			       new_file, reg_file);
 		(void) unlink(new_file);
+		/* The journal no longer matches the job_state file */
+		(void) unlink(journal_file);
 		last_file_write_time = now;
+		journal_ckpt_time = now;
+		journal_ckpt_size = get_buf_offset(buffer);
+		journal_size = 0;
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
+	xfree(journal_file);
 	unlock_state_files();
 
 	free_buf(buffer);
@@ -1002,6 +1293,159 @@ static buf_t *_open_job_state_file(char **state_file)
 	return create_mmap_buf(*state_file);
 }
 
+static int _cmp_journal_entry(const void *x, const void *y)
+{
+	const journal_entry_t *a = x, *b = y;
+
+	if (a->job_id != b->job_id)
+		return (a->job_id > b->job_id) ? 1 : -1;
+	return (a->seq > b->seq) - (a->seq < b->seq);
+}
+
+static int _cmp_journal_job_id(const void *x, const void *y)
+{
+	const journal_entry_t *a = x, *b = y;
+
+	return (a->job_id > b->job_id) - (a->job_id < b->job_id);
+}
+
+/*
+ * Free the job_state file buffer once loaded, unless job records still
+ * reference their packed argv in it
+ */
+static void _release_job_state_map(buf_t *buffer)
+{
+	slurm_mutex_lock(&job_state_map_mutex);
+	if (buffer == job_state_map) {
+		job_state_map_loading = false;
+		if (job_state_map_refs) {
+			debug("%s: %u job records reference the job_state file",
+			      __func__, job_state_map_refs);
+			slurm_mutex_unlock(&job_state_map_mutex);
+			return;
+		}
+		job_state_map = NULL;
+	}
+	slurm_mutex_unlock(&job_state_map_mutex);
+	free_buf(buffer);
+}
+
+static void _free_job_state_journal(job_state_journal_t *journal)
+{
+	if (!journal)
+		return;
+	FREE_NULL_BUFFER(journal->buffer);
+	xfree(journal->entries);
+	xfree(journal->sorted);
+	xfree(journal);
+}
+
+/*
+ * Read the journal extending the job_state file written at ckpt_time.
+ * A truncated last entry, as left by a crash while appending, is ignored.
+ * RET journal or NULL if there is none for this job_state file
+ */
+static job_state_journal_t *_open_job_state_journal(time_t ckpt_time)
+{
+	job_state_journal_t *journal;
+	char *journal_file, *ver_str = NULL;
+	uint32_t ver_str_len, job_id, size, i;
+	time_t buf_time = (time_t) 0;
+	buf_t *buffer;
+	bool header_read = false;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	buffer = create_mmap_buf(journal_file);
+	xfree(journal_file);
+	if (!buffer)
+		return NULL;
+
+	journal = xmalloc(sizeof(*journal));
+	journal->buffer = buffer;
+	journal->protocol_version = NO_VAL16;
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (ver_str && !xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION))
+		safe_unpack16(&journal->protocol_version, buffer);
+	safe_unpack_time(&buf_time, buffer);
+	xfree(ver_str);
+
+	if ((journal->protocol_version < SLURM_21_08_PROTOCOL_VERSION) ||
+	    (journal->protocol_version == NO_VAL16) ||
+	    (buf_time != ckpt_time)) {
+		debug("Ignoring job state journal of job_state file written at %ld",
+		      (long) buf_time);
+		_free_job_state_journal(journal);
+		return NULL;
+	}
+	header_read = true;
+
+	while (remaining_buf(buffer) >= (2 * sizeof(uint32_t))) {
+		safe_unpack32(&job_id, buffer);
+		safe_unpack32(&size, buffer);
+		if (size > remaining_buf(buffer))
+			goto unpack_error;
+		if (job_id == JOURNAL_ID_SEQUENCE) {
+			safe_unpack32(&journal->id_sequence, buffer);
+			continue;
+		}
+		if (!(journal->entry_cnt % 1024)) {
+			xrecalloc(journal->entries, journal->entry_cnt + 1024,
+				  sizeof(journal_entry_t));
+		}
+		journal->entries[journal->entry_cnt].job_id = job_id;
+		journal->entries[journal->entry_cnt].offset =
+			get_buf_offset(buffer);
+		journal->entries[journal->entry_cnt].seq = journal->entry_cnt;
+		journal->entries[journal->entry_cnt].size = size;
+		journal->entry_cnt++;
+		set_buf_offset(buffer, get_buf_offset(buffer) + size);
+	}
+	if (remaining_buf(buffer))
+		goto unpack_error;
+
+	goto sort;
+
+unpack_error:
+	xfree(ver_str);
+	if (!header_read) {
+		error("Invalid job state journal header, ignoring it");
+		_free_job_state_journal(journal);
+		return NULL;
+	}
+	error("Incomplete job state journal, ignoring its last entry");
+
+sort:
+	journal->sorted = xcalloc(journal->entry_cnt + 1,
+				  sizeof(journal_entry_t));
+	if (journal->entry_cnt) {
+		memcpy(journal->sorted, journal->entries,
+		       sizeof(journal_entry_t) * journal->entry_cnt);
+		qsort(journal->sorted, journal->entry_cnt,
+		      sizeof(journal_entry_t), _cmp_journal_entry);
+	}
+	for (i = 0; i < journal->entry_cnt; i++) {
+		if (((i + 1) == journal->entry_cnt) ||
+		    (journal->sorted[i + 1].job_id !=
+		     journal->sorted[i].job_id))
+			journal->entries[journal->sorted[i].seq].latest = true;
+	}
+
+	return journal;
+}
+
+/* Return true if the journal has an entry superseding the job's record */
+static bool _job_in_journal(job_state_journal_t *journal, uint32_t job_id)
+{
+	journal_entry_t key = { .job_id = job_id };
+
+	if (!journal || !journal->entry_cnt)
+		return false;
+	return bsearch(&key, journal->sorted, journal->entry_cnt,
+		       sizeof(journal_entry_t), _cmp_journal_job_id);
+}
+
 extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 {
 	if (!job_ptr->assoc_ptr && (job_ptr->state_reason == FAIL_ACCOUNT)) {
@@ -1102,6 +1546,7 @@ extern void set_job_tres_alloc_str(job_record_t *job_ptr,
 extern void backup_slurmctld_restart(void)
 {
 	last_file_write_time = (time_t) 0;
+	journal_ckpt_time = (time_t) 0;
 }
 
 /* Return the time stamp in the current job state save file, 0 is returned on
@@ -1126,7 +1571,8 @@ static time_t _get_last_job_state_write_time(void)
 		return buf_time;
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	if (ver_str && (!xstrcmp(ver_str, JOB_STATE_VERSION) ||
+			!xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION)))
 		safe_unpack16(&protocol_version, buffer);
 	safe_unpack_time(&buf_time, buffer);
 
@@ -1138,7 +1584,8 @@ unpack_error:
 
 /*
  * load_all_job_state - load the job state from file, recover from last
- *	checkpoint. Execute this after loading the configuration file data.
+ *	checkpoint and apply its journal.
+ *	Execute this after loading the configuration file data.
  *	Changes here should be reflected in load_last_job_id().
  * RET 0 or error code
  */
@@ -1149,12 +1596,17 @@ extern int load_all_job_state(void)
 	char *state_file = NULL;
 	buf_t *buffer;
 	time_t buf_time;
-	uint32_t saved_job_id;
+	uint32_t saved_job_id, job_id, size, end, i;
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	bool framed = false;
+	job_state_journal_t *journal = NULL;
+	journal_entry_t *entry;
+	DEF_TIMERS;
 
 	/* read the file */
+	START_TIMER;
 	lock_state_files();
 	if (!(buffer = _open_job_state_file(&state_file))) {
 		info("No job state file (%s) to recover", state_file);
@@ -1169,7 +1621,8 @@ extern int load_all_job_state(void)
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	framed = !xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION);
+	if (ver_str && (framed || !xstrcmp(ver_str, JOB_STATE_VERSION)))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1189,6 +1642,27 @@ extern int load_all_job_state(void)
 		job_id_sequence = MAX(saved_job_id, job_id_sequence);
 	debug3("Job id in job_state header is %u", saved_job_id);
 
+	/*
+	 * Job argv is left packed in the mapping until it is needed, which for
+	 * most pending jobs is once at launch. The job_state file is only ever
+	 * replaced, never rewritten in place, so the mapping stays valid.
+	 */
+	slurm_mutex_lock(&job_state_map_mutex);
+	if (buffer->mmaped && !job_state_map) {
+		job_state_map = buffer;
+		job_state_map_loading = true;
+	}
+	slurm_mutex_unlock(&job_state_map_mutex);
+
+	if (framed) {
+		lock_state_files();
+		journal = _open_job_state_journal(buf_time);
+		unlock_state_files();
+	}
+	if (journal && journal->id_sequence &&
+	    (journal->id_sequence <= slurm_conf.max_job_id))
+		job_id_sequence = MAX(journal->id_sequence, job_id_sequence);
+
 	/*
 	 * Previously we locked the tres read lock before this loop.  It turned
 	 * out that created a double lock when steps were being loaded during
@@ -1197,26 +1671,92 @@ extern int load_all_job_state(void)
 	 * into the _load_job_state function than any other option.
 	 */
 	while (remaining_buf(buffer) > 0) {
-		error_code = _load_job_state(buffer, protocol_version);
+		if (framed) {
+			/* Skip jobs with a newer record in the journal */
+			safe_unpack32(&job_id, buffer);
+			safe_unpack32(&size, buffer);
+			if (size > remaining_buf(buffer))
+				goto unpack_error;
+			end = get_buf_offset(buffer) + size;
+			if (_job_in_journal(journal, job_id)) {
+				set_buf_offset(buffer, end);
+				continue;
+			}
+			error_code = _load_job_state(buffer, protocol_version);
+			if ((error_code == SLURM_SUCCESS) &&
+			    (get_buf_offset(buffer) != end))
+				error_code = SLURM_ERROR;
+		} else {
+			error_code = _load_job_state(buffer, protocol_version);
+		}
+		if (error_code != SLURM_SUCCESS)
+			goto unpack_error;
+		job_cnt++;
+	}
+
+	for (i = 0; journal && (i < journal->entry_cnt); i++) {
+		entry = &journal->entries[i];
+		if (!entry->latest || !entry->size)
+			continue;
+		set_buf_offset(journal->buffer, entry->offset);
+		error_code = _load_job_state(journal->buffer,
+					     journal->protocol_version);
+		if ((error_code == SLURM_SUCCESS) &&
+		    (get_buf_offset(journal->buffer) !=
+		     (entry->offset + entry->size)))
+			error_code = SLURM_ERROR;
 		if (error_code != SLURM_SUCCESS)
 			goto unpack_error;
 		job_cnt++;
 	}
+	if (journal)
+		info("Applied %u job state journal entries", journal->entry_cnt);
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
-	free_buf(buffer);
-	info("Recovered information about %d jobs", job_cnt);
+	_free_job_state_journal(journal);
+	_release_job_state_map(buffer);
+	END_TIMER;
+	info("Recovered information about %d jobs %s", job_cnt, TIME_STR);
 	return error_code;
 
 unpack_error:
 	if (!ignore_state_errors)
 		fatal("Incomplete job state save file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
 	error("Incomplete job state save file");
-	info("Recovered information about %d jobs", job_cnt);
-	free_buf(buffer);
+	END_TIMER;
+	info("Recovered information about %d jobs %s", job_cnt, TIME_STR);
+	_free_job_state_journal(journal);
+	_release_job_state_map(buffer);
 	return SLURM_ERROR;
 }
 
+/*
+ * load_job_details_argv - unpack a job's argv if it was left packed in the
+ *	mapped job_state file at startup. Call before using argc or argv.
+ * IN detail_ptr - job details, may be NULL
+ */
+extern void load_job_details_argv(struct job_details *detail_ptr)
+{
+	uint32_t offset;
+
+	if (!detail_ptr || !detail_ptr->argv_len)
+		return;
+
+	/* Jobs read under the job read lock may race to do this */
+	slurm_mutex_lock(&job_state_map_mutex);
+	if (detail_ptr->argv_len) {
+		offset = get_buf_offset(job_state_map);
+		set_buf_offset(job_state_map, detail_ptr->argv_offset);
+		/* Checked by skipstr_array() when the job was loaded */
+		if (unpackstr_array(&detail_ptr->argv, &detail_ptr->argc,
+				    job_state_map))
+			error("%s: unable to unpack argv", __func__);
+		set_buf_offset(job_state_map, offset);
+		_unref_packed_argv(detail_ptr);
+	}
+	slurm_mutex_unlock(&job_state_map_mutex);
+}
+
 /*
  * load_last_job_id - load only the last job ID from state save file.
  *	Changes here should be reflected in load_all_job_state().
@@ -1230,6 +1770,7 @@ extern int load_last_job_id( void )
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	bool framed = false;
 
 	/* read the file */
 	lock_state_files();
@@ -1244,7 +1785,8 @@ extern int load_last_job_id( void )
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	framed = !xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION);
+	if (ver_str && (framed || !xstrcmp(ver_str, JOB_STATE_VERSION)))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1264,6 +1806,20 @@ extern int load_last_job_id( void )
 
 	/* Ignore the state for individual jobs stored here */
 
+	if (framed) {
+		job_state_journal_t *journal;
+
+		lock_state_files();
+		journal = _open_job_state_journal(buf_time);
+		unlock_state_files();
+		if (journal && journal->id_sequence) {
+			job_id_sequence = journal->id_sequence;
+			debug3("Job ID in job state journal is %u",
+			       job_id_sequence);
+		}
+		_free_job_state_journal(journal);
+	}
+
 	xfree(ver_str);
 	free_buf(buffer);
 	return SLURM_SUCCESS;
@@ -2288,7 +2844,7 @@ static int _load_job_state(buf_t *buffer, uint16_t protocol_version)
 		_job_fail_account(job_ptr, __func__);
 	} else {
 		job_ptr->assoc_id = assoc_rec.id;
-		info("Recovered %pJ Assoc=%u", job_ptr, job_ptr->assoc_id);
+		debug("Recovered %pJ Assoc=%u", job_ptr, job_ptr->assoc_id);
 
 		if (job_ptr->state_reason == FAIL_ACCOUNT) {
 			job_ptr->state_reason = WAIT_NO_REASON;
@@ -2494,7 +3050,8 @@ void _dump_job_details(struct job_details *detail_ptr, buf_t *buffer)
 
 	pack_multi_core_data(detail_ptr->mc_ptr, buffer,
 			     SLURM_PROTOCOL_VERSION);
-	packstr_array(detail_ptr->argv, detail_ptr->argc, buffer);
+	if (!detail_ptr->argv_len || !_pack_mapped_argv(detail_ptr, buffer))
+		packstr_array(detail_ptr->argv, detail_ptr->argc, buffer);
 	packstr_array(detail_ptr->env_sup, detail_ptr->env_cnt, buffer);
 
 	pack_cron_entry(detail_ptr->crontab_entry, SLURM_PROTOCOL_VERSION,
@@ -2518,6 +3075,7 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	uint32_t cpu_freq_max = NO_VAL;
 	uint32_t cpu_freq_gov = NO_VAL, nice = 0;
 	uint32_t num_tasks, name_len, argc = 0, env_cnt = 0, task_dist;
+	uint32_t argv_offset = 0, argv_len = 0;
 	uint16_t contiguous, core_spec = NO_VAL16;
 	uint16_t ntasks_per_node, cpus_per_task, requeue;
 	uint16_t cpu_bind_type, mem_bind_type, plane_size;
@@ -2584,7 +3142,14 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 
 		if (unpack_multi_core_data(&mc_ptr, buffer, protocol_version))
 			goto unpack_error;
-		safe_unpackstr_array(&argv, &argc, buffer);
+		if (buffer == job_state_map) {
+			/* Left in the mapping until load_job_details_argv() */
+			argv_offset = get_buf_offset(buffer);
+			if (skipstr_array(buffer))
+				goto unpack_error;
+			argv_len = get_buf_offset(buffer) - argv_offset;
+		} else
+			safe_unpackstr_array(&argv, &argc, buffer);
 		safe_unpackstr_array(&env_sup, &env_cnt, buffer);
 
 		if (unpack_cron_entry((void **) &crontab_entry,
@@ -2671,6 +3236,7 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 
 	/* free any left-over detail data */
 	xfree(job_ptr->details->acctg_freq);
+	_drop_packed_argv(job_ptr->details);
 	for (i=0; i<job_ptr->details->argc; i++)
 		xfree(job_ptr->details->argv[i]);
 	xfree(job_ptr->details->argv);
@@ -2695,6 +3261,13 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	job_ptr->details->acctg_freq = acctg_freq;
 	job_ptr->details->argc = argc;
 	job_ptr->details->argv = argv;
+	if (argv_len) {
+		slurm_mutex_lock(&job_state_map_mutex);
+		job_ptr->details->argv_len = argv_len;
+		job_ptr->details->argv_offset = argv_offset;
+		job_state_map_refs++;
+		slurm_mutex_unlock(&job_state_map_mutex);
+	}
 	job_ptr->details->accrue_time = accrue_time;
 	job_ptr->details->begin_time = begin_time;
 	job_ptr->details->contiguous = contiguous;
@@ -2777,6 +3350,98 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Fibonacci hashing, so that sequential keys do not form long probe runs */
+static uint32_t _job_index_home(job_index_t *index, uint32_t key)
+{
+	return (key * 2654435769U) >> index->shift;
+}
+
+/* Allocate an empty index with at least slot_cnt slots */
+static void _job_index_alloc(job_index_t *index, uint32_t slot_cnt)
+{
+	uint32_t size = JOB_INDEX_MIN_SLOTS;
+	uint8_t shift = 32 - 10;	/* log2(JOB_INDEX_MIN_SLOTS) */
+
+	while ((size < slot_cnt) && (shift > 1)) {
+		size <<= 1;
+		shift--;
+	}
+	index->cnt = 0;
+	index->mask = size - 1;
+	index->shift = shift;
+	index->slots = xcalloc(size, sizeof(job_index_slot_t));
+}
+
+static job_index_slot_t *_job_index_find(job_index_t *index, uint32_t key)
+{
+	uint32_t i;
+
+	if (!index->slots)
+		return NULL;
+
+	for (i = _job_index_home(index, key); index->slots[i].job_ptr;
+	     i = (i + 1) & index->mask) {
+		if (index->slots[i].key == key)
+			return &index->slots[i];
+	}
+
+	return NULL;
+}
+
+/* Insert key, or point an existing key at job_ptr instead */
+static void _job_index_insert(job_index_t *index, uint32_t key,
+			      job_record_t *job_ptr)
+{
+	job_index_slot_t *old_slots;
+	uint32_t i, old_size;
+
+	if (!index->slots) {
+		_job_index_alloc(index, JOB_INDEX_MIN_SLOTS);
+	} else if (((index->cnt + 1) * 2) > (index->mask + 1)) {
+		/* Double the slot count, rehashing all entries */
+		old_slots = index->slots;
+		old_size = index->mask + 1;
+		_job_index_alloc(index, old_size * 2);
+		for (i = 0; i < old_size; i++) {
+			if (old_slots[i].job_ptr)
+				_job_index_insert(index, old_slots[i].key,
+						  old_slots[i].job_ptr);
+		}
+		xfree(old_slots);
+	}
+
+	for (i = _job_index_home(index, key); index->slots[i].job_ptr;
+	     i = (i + 1) & index->mask) {
+		if (index->slots[i].key == key) {
+			index->slots[i].job_ptr = job_ptr;
+			return;
+		}
+	}
+	index->slots[i].key = key;
+	index->slots[i].job_ptr = job_ptr;
+	index->cnt++;
+}
+
+/*
+ * Empty a slot. Later entries of the probe run are shifted back into the
+ * hole where their home slot allows it, so no tombstones are needed.
+ */
+static void _job_index_remove(job_index_t *index, job_index_slot_t *slot)
+{
+	uint32_t i = slot - index->slots, j, home;
+
+	for (j = (i + 1) & index->mask; index->slots[j].job_ptr;
+	     j = (j + 1) & index->mask) {
+		home = _job_index_home(index, index->slots[j].key);
+		if (((j - home) & index->mask) >= ((j - i) & index->mask)) {
+			index->slots[i] = index->slots[j];
+			i = j;
+		}
+	}
+	index->slots[i].job_ptr = NULL;
+	index->cnt--;
+}
+
 /* _add_job_hash - add a job hash entry for given job record, job_id must
  *	already be set
  * IN job_ptr - pointer to job record
@@ -2784,11 +3449,43 @@ unpack_error:
  */
 static void _add_job_hash(job_record_t *job_ptr)
 {
-	int inx;
+	job_index_slot_t *slot;
+
+	_job_index_insert(&job_id_index, job_ptr->job_id, job_ptr);
+
+	/* Link the record at the head of its user's job list */
+	_unlink_job_user(job_ptr);
+	if ((slot = _job_index_find(&job_user_index, job_ptr->user_id))) {
+		job_ptr->job_user_next = slot->job_ptr;
+		slot->job_ptr->job_user_prev = job_ptr;
+		slot->job_ptr = job_ptr;
+	} else {
+		_job_index_insert(&job_user_index, job_ptr->user_id, job_ptr);
+	}
+}
+
+/* Remove a job record from its user's job list, if linked there */
+static void _unlink_job_user(job_record_t *job_ptr)
+{
+	job_index_slot_t *slot;
+
+	if (job_ptr->job_user_prev) {
+		job_ptr->job_user_prev->job_user_next = job_ptr->job_user_next;
+	} else if ((slot = _job_index_find(&job_user_index,
+					   job_ptr->user_id)) &&
+		   (slot->job_ptr == job_ptr)) {
+		if (job_ptr->job_user_next)
+			slot->job_ptr = job_ptr->job_user_next;
+		else
+			_job_index_remove(&job_user_index, slot);
+	} else {
+		return;
+	}
 
-	inx = JOB_HASH_INX(job_ptr->job_id);
-	job_ptr->job_next = job_hash[inx];
-	job_hash[inx] = job_ptr;
+	if (job_ptr->job_user_next)
+		job_ptr->job_user_next->job_user_prev = job_ptr->job_user_prev;
+	job_ptr->job_user_next = NULL;
+	job_ptr->job_user_prev = NULL;
 }
 
 /* _remove_job_hash - remove a job hash entry for given job record, job_id must
@@ -2800,13 +3497,20 @@ static void _add_job_hash(job_record_t *job_ptr)
 static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 {
 	job_record_t *job_ptr, **job_pptr;
+	job_index_slot_t *slot;
 
 	xassert(job_entry);
 
 	switch (type) {
 	case JOB_HASH_JOB:
-		job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
-		break;
+		_unlink_job_user(job_entry);
+		slot = _job_index_find(&job_id_index, job_entry->job_id);
+		if (slot && (slot->job_ptr == job_entry))
+			_job_index_remove(&job_id_index, slot);
+		else if (job_entry->job_id != NO_VAL)
+			error("%s: Could not find hash entry for JobId=%u",
+			      __func__, job_entry->job_id);
+		return;
 	case JOB_HASH_ARRAY_JOB:
 		job_pptr = &job_array_hash_j[
 			JOB_HASH_INX(job_entry->array_job_id)];
@@ -2825,15 +3529,14 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 	       ((job_ptr = *job_pptr) != job_entry)) {
 		xassert(job_ptr->magic == JOB_MAGIC);
 		switch (type) {
-		case JOB_HASH_JOB:
-			job_pptr = &job_ptr->job_next;
-			break;
 		case JOB_HASH_ARRAY_JOB:
 			job_pptr = &job_ptr->job_array_next_j;
 			break;
 		case JOB_HASH_ARRAY_TASK:
 			job_pptr = &job_ptr->job_array_next_t;
 			break;
+		default:
+			break;
 		}
 	}
 
@@ -2842,10 +3545,6 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 			return;
 
 		switch (type) {
-		case JOB_HASH_JOB:
-			error("%s: Could not find hash entry for JobId=%u",
-			      __func__, job_entry->job_id);
-			break;
 		case JOB_HASH_ARRAY_JOB:
 			error("%s: job array hash error %u", __func__,
 			      job_entry->array_job_id);
@@ -2856,15 +3555,13 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 			      job_entry->array_job_id,
 			      job_entry->array_task_id);
 			break;
+		default:
+			break;
 		}
 		return;
 	}
 
 	switch (type) {
-	case JOB_HASH_JOB:
-		*job_pptr = job_entry->job_next;
-		job_entry->job_next = NULL;
-		break;
 	case JOB_HASH_ARRAY_JOB:
 		*job_pptr = job_entry->job_array_next_j;
 		job_entry->job_array_next_j = NULL;
@@ -2873,6 +3570,8 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 		*job_pptr = job_entry->job_array_next_t;
 		job_entry->job_array_next_t = NULL;
 		break;
+	default:
+		break;
 	}
 }
 
@@ -3159,12 +3858,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
 	job_record_t *het_job_leader, *het_job;
 	ListIterator iter;
 
-	het_job_leader = job_hash[JOB_HASH_INX(job_id)];
-	while (het_job_leader) {
-		if (het_job_leader->job_id == job_id)
-			break;
-		het_job_leader = het_job_leader->job_next;
-	}
+	het_job_leader = find_job_record(job_id);
 	if (!het_job_leader)
 		return NULL;
 	if (het_job_leader->het_job_offset == het_job_id)
@@ -3194,16 +3888,28 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
  */
 extern job_record_t *find_job_record(uint32_t job_id)
 {
-	job_record_t *job_ptr;
+	job_index_slot_t *slot = _job_index_find(&job_id_index, job_id);
 
-	job_ptr = job_hash[JOB_HASH_INX(job_id)];
-	while (job_ptr) {
-		if (job_ptr->job_id == job_id)
-			return job_ptr;
-		job_ptr = job_ptr->job_next;
+	return slot ? slot->job_ptr : NULL;
+}
+
+extern int foreach_user_job(uid_t uid, ListForF f, void *arg)
+{
+	job_index_slot_t *slot;
+	job_record_t *job_ptr, *next_ptr;
+	int cnt = 0;
+
+	if (!(slot = _job_index_find(&job_user_index, uid)))
+		return 0;
+
+	for (job_ptr = slot->job_ptr; job_ptr; job_ptr = next_ptr) {
+		next_ptr = job_ptr->job_user_next;
+		cnt++;
+		if (f(job_ptr, arg) < 0)
+			return -cnt;
 	}
 
-	return NULL;
+	return cnt;
 }
 
 /* rebuild a job's partition name list based upon the contents of its
@@ -4219,9 +4925,28 @@ int init_job_conf(void)
 		purge_files_list = list_create(xfree_ptr);
 	}
 
+	if (!purged_job_log) {
+		purged_job_log = list_create(xfree_ptr);
+		purged_log_start = last_job_update;
+	}
+
+	if (!journal_purged_ids)
+		journal_purged_ids = list_create(xfree_ptr);
+
 	return SLURM_SUCCESS;
 }
 
+static int _rehash_job_array(void *x, void *arg)
+{
+	job_record_t *job_ptr = x;
+
+	/* Unlinked records are already gone from the hash tables */
+	if (job_ptr->job_id != NO_VAL)
+		_add_job_array_hash(job_ptr);
+
+	return 0;
+}
+
 /*
  * rehash_jobs - Create or rebuild the job hash table.
  */
@@ -4230,20 +4955,29 @@ extern void rehash_jobs(void)
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
 
-	if (job_hash == NULL) {
+	if (job_array_hash_j == NULL) {
+		/* The job ID index grows itself, size it to avoid that */
+		_job_index_alloc(&job_id_index, slurm_conf.max_job_cnt * 2);
 		hash_table_size = slurm_conf.max_job_cnt;
-		job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
 		job_array_hash_j = xcalloc(hash_table_size,
 					   sizeof(job_record_t *));
 		job_array_hash_t = xcalloc(hash_table_size,
 					   sizeof(job_record_t *));
 	} else if (hash_table_size < (slurm_conf.max_job_cnt / 2)) {
-		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurm_conf.max_job_cnt = hash_table_size;
+		/*
+		 * If the MaxJobCount grows by too much, the job array hash
+		 * tables will be ineffective, so rebuild them.
+		 */
+		info("%s: MaxJobCount increased, rebuilding job array hash tables",
+		     __func__);
+		hash_table_size = slurm_conf.max_job_cnt;
+		xfree(job_array_hash_j);
+		xfree(job_array_hash_t);
+		job_array_hash_j = xcalloc(hash_table_size,
+					   sizeof(job_record_t *));
+		job_array_hash_t = xcalloc(hash_table_size,
+					   sizeof(job_record_t *));
+		list_for_each(job_list, _rehash_job_array, NULL);
 	}
 }
 
@@ -4340,8 +5074,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	memcpy(job_ptr_pend->limit_set.tres, job_ptr->limit_set.tres,
 	       sizeof(uint16_t) * slurmctld_tres_cnt);
 
-	_add_job_hash(job_ptr);		/* Sets job_next */
-	_add_job_hash(job_ptr_pend);	/* Sets job_next */
+	_add_job_hash(job_ptr);
+	_add_job_hash(job_ptr_pend);
 	_add_job_array_hash(job_ptr);
 	job_ptr_pend->job_resrcs = NULL;
 
@@ -4419,6 +5153,11 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	details_new->preempt_start_time = 0;
 
 	details_new->acctg_freq = xstrdup(job_details->acctg_freq);
+	if (details_new->argv_len) {
+		slurm_mutex_lock(&job_state_map_mutex);
+		job_state_map_refs++;
+		slurm_mutex_unlock(&job_state_map_mutex);
+	}
 	if (job_details->argc) {
 		details_new->argv =
 			xcalloc((job_details->argc + 1), sizeof(char *));
@@ -7965,10 +8704,10 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	job_ptr->tres_req_cnt = job_desc->tres_req_cnt;
 	job_desc->tres_req_cnt = NULL;
 	set_job_tres_req_str(job_ptr, false);
-	_add_job_hash(job_ptr);
 
 	job_ptr->user_id    = (uid_t) job_desc->user_id;
 	job_ptr->group_id   = (gid_t) job_desc->group_id;
+	_add_job_hash(job_ptr);
 	job_ptr->job_state  = JOB_PENDING;
 	job_ptr->time_limit = job_desc->time_limit;
 	job_ptr->deadline   = job_desc->deadline;
@@ -9227,6 +9966,61 @@ static void _delete_job_common(job_record_t *job_ptr)
 	}
 }
 
+/* Return FNV-1a hash of buffer's data from offset to the current offset */
+static uint64_t _hash_buf_data(buf_t *buffer, uint32_t offset)
+{
+	unsigned char *data = (unsigned char *) get_buf_data(buffer);
+	uint32_t end = get_buf_offset(buffer);
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (; offset < end; offset++) {
+		hash ^= data[offset];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/* Note a purged job record for the next job state journal append */
+static void _journal_purged_job(uint32_t job_id)
+{
+	uint32_t *purged_id;
+
+	if (!journal_purged_ids || !job_id || (job_id == NO_VAL))
+		return;
+
+	purged_id = xmalloc(sizeof(*purged_id));
+	*purged_id = job_id;
+	list_append(journal_purged_ids, purged_id);
+}
+
+/*
+ * Remember the ID of a job record being purged so that SHOW_DELTA job info
+ * requests can tell clients to drop it. Entries older than
+ * PURGED_JOB_LOG_AGE are discarded.
+ */
+static void _log_purged_job(uint32_t job_id)
+{
+	purged_job_t *purged;
+	time_t now = time(NULL), min_time = now - PURGED_JOB_LOG_AGE;
+
+	if (!purged_job_log)
+		return;
+
+	/* Entries are appended in time order, trim from the head */
+	while ((purged = list_peek(purged_job_log)) &&
+	       (purged->purge_time < min_time)) {
+		purged_log_start = purged->purge_time + 1;
+		list_pop(purged_job_log);
+		xfree(purged);
+	}
+
+	purged = xmalloc(sizeof(*purged));
+	purged->job_id = job_id;
+	purged->purge_time = now;
+	list_append(purged_job_log, purged);
+}
+
 /*
  * _list_delete_job - delete a job record and its corresponding job_details,
  *	see common/list.h for documentation
@@ -9242,6 +10036,8 @@ static void _list_delete_job(void *job_entry)
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
 	_delete_job_common(job_ptr);
+	_log_purged_job(job_ptr->job_id);
+	_journal_purged_job(job_ptr->job_id);
 
 	if (job_ptr->array_recs) {
 		job_array_size = MAX(1, job_ptr->array_recs->task_cnt);
@@ -9492,10 +10288,50 @@ static bool _hide_job(job_record_t *job_ptr, uid_t uid, uint16_t show_flags)
 	return false;
 }
 
+static void _add_purged_id(_foreach_pack_job_info_t *pack_info,
+			   uint32_t job_id)
+{
+	if (!(pack_info->purged_cnt % 64)) {
+		xrecalloc(pack_info->purged_ids, pack_info->purged_cnt + 64,
+			  sizeof(uint32_t));
+	}
+	pack_info->purged_ids[pack_info->purged_cnt++] = job_id;
+}
+
+static int _foreach_purged_since(void *x, void *arg)
+{
+	purged_job_t *purged = (purged_job_t *) x;
+	_foreach_pack_job_info_t *pack_info = (_foreach_pack_job_info_t *)arg;
+
+	if (purged->purge_time >= pack_info->changed_since)
+		_add_purged_id(pack_info, purged->job_id);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Hash the job record just packed into buffer at offset and
+ * remember when the hash last changed. Caller must hold pack_hash_mutex.
+ * RET time at which the packed job information last changed
+ */
+static time_t _job_info_change_time(job_record_t *job_ptr, buf_t *buffer,
+				    uint32_t offset, time_t now)
+{
+	uint64_t hash = _hash_buf_data(buffer, offset);
+
+	if (job_ptr->info_hash != hash) {
+		job_ptr->info_hash = hash;
+		job_ptr->info_change_time = now;
+	}
+
+	return job_ptr->info_change_time;
+}
+
 static int _pack_job(void *object, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *)object;
 	_foreach_pack_job_info_t *pack_info = (_foreach_pack_job_info_t *)arg;
+	uint32_t offset;
 
 	xassert (job_ptr->magic == JOB_MAGIC);
 
@@ -9508,12 +10344,26 @@ static int _pack_job(void *object, void *arg)
 	    _all_parts_hidden(job_ptr, pack_info->uid))
 		return SLURM_SUCCESS;
 
-	if (_hide_job(job_ptr, pack_info->uid, pack_info->show_flags))
+	if (_hide_job(job_ptr, pack_info->uid, pack_info->show_flags)) {
+		/* Client may still hold the job from before it was revoked */
+		if (pack_info->delta && IS_JOB_REVOKED(job_ptr))
+			_add_purged_id(pack_info, job_ptr->job_id);
 		return SLURM_SUCCESS;
+	}
 
+	offset = get_buf_offset(pack_info->buffer);
 	pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
 		 pack_info->protocol_version, pack_info->uid);
 
+	if (pack_info->track_changes &&
+	    (_job_info_change_time(job_ptr, pack_info->buffer, offset,
+				   pack_info->now) <
+	     pack_info->changed_since)) {
+		/* Unchanged since the client's last update, drop it */
+		set_buf_offset(pack_info->buffer, offset);
+		return SLURM_SUCCESS;
+	}
+
 	(*pack_info->jobs_packed)++;
 
 	return SLURM_SUCCESS;
@@ -9531,6 +10381,20 @@ static int _foreach_pack_jobid(void *object, void *arg)
 	return _pack_job(job_ptr, info);
 }
 
+/*
+ * Pack the end of a job information message: whether it only holds the
+ * changes since the client's last update and which jobs it should drop.
+ */
+static void _pack_job_info_trailer(_foreach_pack_job_info_t *pack_info)
+{
+	if (pack_info->protocol_version < SLURM_21_08_PROTOCOL_VERSION)
+		return;
+
+	packbool(pack_info->delta, pack_info->buffer);
+	pack32_array(pack_info->purged_ids, pack_info->purged_cnt,
+		     pack_info->buffer);
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -9539,6 +10403,8 @@ static int _foreach_pack_jobid(void *object, void *arg)
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN changed_since - with SHOW_DELTA in show_flags, only pack jobs changed
+ *	and list jobs purged since this time
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9546,11 +10412,12 @@ static int _foreach_pack_jobid(void *object, void *arg)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			  uint16_t protocol_version)
+			  time_t changed_since, uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
 	_foreach_pack_job_info_t pack_info = {0};
 	buf_t *buffer;
+	time_t now = time(NULL);
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
@@ -9560,17 +10427,44 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
 	pack32(jobs_packed, buffer);
-	pack_time(time(NULL), buffer);
+	pack_time(now, buffer);
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
+	pack_info.now              = now;
 	pack_info.protocol_version = protocol_version;
 	pack_info.show_flags       = show_flags;
 	pack_info.uid              = uid;
 
-	list_for_each(job_list, _pack_job, &pack_info);
+	/*
+	 * Change times are tracked for every SHOW_DELTA request, including
+	 * the client's initial full one, so that later deltas are relative
+	 * to what it actually received. A delta is only possible if every
+	 * job purged since changed_since is still remembered.
+	 */
+	if ((show_flags & SHOW_DELTA) && (filter_uid == NO_VAL) &&
+	    (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)) {
+		pack_info.track_changes = true;
+		if (changed_since && (changed_since >= purged_log_start)) {
+			pack_info.changed_since = changed_since;
+			pack_info.delta = true;
+			list_for_each(purged_job_log, _foreach_purged_since,
+				      &pack_info);
+		}
+	}
+
+	if (pack_info.track_changes)
+		slurm_mutex_lock(&pack_hash_mutex);
+	if (filter_uid != NO_VAL)
+		foreach_user_job(filter_uid, _pack_job, &pack_info);
+	else
+		list_for_each(job_list, _pack_job, &pack_info);
+	if (pack_info.track_changes)
+		slurm_mutex_unlock(&pack_hash_mutex);
+	_pack_job_info_trailer(&pack_info);
+	xfree(pack_info.purged_ids);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
@@ -9625,6 +10519,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	pack_info.uid              = uid;
 
 	list_for_each(job_ids, _foreach_pack_jobid, &pack_info);
+	_pack_job_info_trailer(&pack_info);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
@@ -9677,6 +10572,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 {
 	job_record_t *job_ptr;
 	uint32_t jobs_packed = 0, tmp_offset;
+	_foreach_pack_job_info_t pack_info = {0};
 	buf_t *buffer;
 
 	buffer_ptr[0] = NULL;
@@ -9738,6 +10634,10 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 		return ESLURM_INVALID_JOB_ID;
 	}
 
+	pack_info.buffer = buffer;
+	pack_info.protocol_version = protocol_version;
+	_pack_job_info_trailer(&pack_info);
+
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
 	set_buf_offset(buffer, 0);
@@ -10091,6 +10991,7 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 			packstr(detail_ptr->work_dir, buffer);
 			packstr(detail_ptr->dependency, buffer);
 
+			load_job_details_argv(detail_ptr);
 			if (detail_ptr->argv) {
 				char *cmd_line = NULL, *pos = NULL;
 				for (i = 0; detail_ptr->argv[i]; i++) {
@@ -10240,6 +11141,7 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 			packstr(detail_ptr->work_dir,   buffer);
 			packstr(detail_ptr->dependency, buffer);
 
+			load_job_details_argv(detail_ptr);
 			if (detail_ptr->argv) {
 				char *cmd_line = NULL, *pos = NULL;
 				for (i = 0; detail_ptr->argv[i]; i++) {
@@ -10596,6 +11498,7 @@ extern void unlink_job_record(job_record_t *job_ptr)
 	xassert(job_ptr->magic == JOB_MAGIC);
 
 	_delete_job_common(job_ptr);
+	_journal_purged_job(job_ptr->job_id);
 
 	job_id = xmalloc(sizeof(uint32_t));
 	*job_id = job_ptr->job_id;
@@ -15035,10 +15938,13 @@ void batch_requeue_fini(job_record_t *job_ptr)
 void job_fini (void)
 {
 	FREE_NULL_LIST(job_list);
-	xfree(job_hash);
+	xfree(job_id_index.slots);
+	xfree(job_user_index.slots);
 	xfree(job_array_hash_j);
 	xfree(job_array_hash_t);
 	FREE_NULL_LIST(purge_files_list);
+	FREE_NULL_LIST(purged_job_log);
+	FREE_NULL_LIST(journal_purged_ids);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
 }
@@ -17043,6 +17949,8 @@ extern job_desc_msg_t *copy_job_record_to_job_desc(job_record_t *job_ptr)
 	multi_core_data_t *mc_ptr = details->mc_ptr;
 	int i;
 
+	load_job_details_argv(details);
+
 	/* construct a job_desc_msg_t from job */
 	job_desc = xmalloc(sizeof(job_desc_msg_t));
 
@@ -105,8 +105,7 @@ typedef struct wait_boot_arg {
 	bitstr_t *node_bitmap;
 } wait_boot_arg_t;
 
-static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
-						     uint16_t protocol_version);
+static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr);
 static void	_job_queue_append(List job_queue, job_record_t *job_ptr,
 				  part_record_t *part_ptr, uint32_t priority);
 static bool	_job_runnable_test1(job_record_t *job_ptr, bool clear_start);
@@ -1009,6 +1008,7 @@ static int _schedule(bool full_queue)
 {
 	ListIterator job_iterator = NULL, part_iterator = NULL;
 	List job_queue = NULL;
+	job_queue_heap_t *job_queue_heap = NULL;
 	int failed_part_cnt = 0, failed_resv_cnt = 0, job_cnt = 0;
 	int error_code, i, j, part_cnt, time_limit, pend_time;
 	uint32_t job_depth = 0, array_task_id;
@@ -1037,6 +1037,8 @@ static int _schedule(bool full_queue)
 	time_t now, last_job_sched_start, sched_start;
 	job_record_t *reject_array_job = NULL;
 	part_record_t *reject_array_part = NULL;
+	xhash_t *failed_classes = NULL;
+	uint64_t job_class = 0;
 	bool fail_by_part, wait_on_resv;
 	uint32_t deadline_time_limit, save_time_limit = 0;
 	uint32_t prio_reserve;
@@ -1382,8 +1384,9 @@ static int _schedule(bool full_queue)
 	} else {
 		job_queue = build_job_queue(false, false);
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
-		sort_job_queue(job_queue);
+		job_queue_heap = job_queue_heap_create(job_queue);
 	}
+	failed_classes = sched_class_table_create();
 
 	job_ptr = NULL;
 	wait_on_resv = false;
@@ -1440,7 +1443,7 @@ next_part:
 					continue;
 			}
 		} else {
-			job_queue_rec = list_pop(job_queue);
+			job_queue_rec = job_queue_heap_pop(job_queue_heap);
 			if (!job_queue_rec)
 				break;
 			array_task_id = job_queue_rec->array_task_id;
@@ -1744,6 +1747,21 @@ next_task:
 			job_ptr->time_limit = deadline_time_limit;
 		}
 
+		/*
+		 * avail_node_bitmap only shrinks during the pass, so a job
+		 * identical to one that already failed would fail too.
+		 */
+		job_class = job_sched_class(job_ptr);
+		if (sched_class_fail_cnt(failed_classes, job_class)) {
+			if (job_ptr->state_reason != WAIT_RESOURCES) {
+				job_ptr->state_reason = WAIT_RESOURCES;
+				xfree(job_ptr->state_desc);
+				last_job_update = now;
+			}
+			error_code = ESLURM_NODES_BUSY;
+			goto skip_start;
+		}
+
 		/* get fed job lock from origin cluster */
 		if (fed_mgr_job_lock(job_ptr)) {
 			error_code = ESLURM_FED_JOB_LOCK;
@@ -1776,6 +1794,7 @@ skip_start:
 				     job_state_string(job_ptr->job_state),
 				     job_reason_string(job_ptr->state_reason),
 				     job_ptr->priority, job_ptr->partition);
+			sched_class_add_fail(failed_classes, job_class);
 			fail_by_part = true;
 		} else if (error_code == ESLURM_BURST_BUFFER_WAIT) {
 			if (job_ptr->start_time == 0) {
@@ -1948,6 +1967,7 @@ fail_this_part:	if (fail_by_part) {
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	xfree(failed_resv);
+	xhash_free(failed_classes);
 	if (fifo_sched) {
 		if (job_iterator)
 			list_iterator_destroy(job_iterator);
@@ -1955,6 +1975,7 @@ fail_this_part:	if (fail_by_part) {
 			list_iterator_destroy(part_iterator);
 	} else if (job_queue) {
 		FREE_NULL_LIST(job_queue);
+		job_queue_heap_free(job_queue_heap);
 	}
 	xfree(sched_part_ptr);
 	xfree(sched_part_jobs);
@@ -1989,6 +2010,219 @@ extern void sort_job_queue(List job_queue)
 	list_sort(job_queue, sort_job_queue2);
 }
 
+/* Restore the heap order below index inx */
+static void _job_queue_heap_down(job_queue_heap_t *heap, int inx)
+{
+	job_queue_rec_t **recs = heap->recs, *tmp;
+	int child, first;
+
+	while (1) {
+		first = inx;
+		child = (2 * inx) + 1;
+		if ((child < heap->rec_cnt) &&
+		    (sort_job_queue2(&recs[child], &recs[first]) < 0))
+			first = child;
+		child++;
+		if ((child < heap->rec_cnt) &&
+		    (sort_job_queue2(&recs[child], &recs[first]) < 0))
+			first = child;
+		if (first == inx)
+			break;
+		tmp = recs[inx];
+		recs[inx] = recs[first];
+		recs[first] = tmp;
+		inx = first;
+	}
+}
+
+extern job_queue_heap_t *job_queue_heap_create(List job_queue)
+{
+	job_queue_heap_t *heap = xmalloc(sizeof(*heap));
+	job_queue_rec_t *job_queue_rec;
+	int i;
+
+	heap->recs = xcalloc(list_count(job_queue) + 1,
+			     sizeof(job_queue_rec_t *));
+	while ((job_queue_rec = list_pop(job_queue)))
+		heap->recs[heap->rec_cnt++] = job_queue_rec;
+	for (i = (heap->rec_cnt / 2) - 1; i >= 0; i--)
+		_job_queue_heap_down(heap, i);
+
+	return heap;
+}
+
+extern job_queue_rec_t *job_queue_heap_pop(job_queue_heap_t *heap)
+{
+	job_queue_rec_t *job_queue_rec;
+
+	if (!heap->rec_cnt)
+		return NULL;
+
+	job_queue_rec = heap->recs[0];
+	heap->recs[0] = heap->recs[--heap->rec_cnt];
+	_job_queue_heap_down(heap, 0);
+
+	return job_queue_rec;
+}
+
+extern void job_queue_heap_free(job_queue_heap_t *heap)
+{
+	if (!heap)
+		return;
+
+	while (heap->rec_cnt)
+		xfree(heap->recs[--heap->rec_cnt]);
+	xfree(heap->recs);
+	xfree(heap);
+}
+
+typedef struct {
+	uint64_t class;		/* job_sched_class() value */
+	uint32_t fail_cnt;	/* members that could not start this pass */
+} sched_class_rec_t;
+
+#define SCHED_CLASS_FNV_PRIME 0x100000001b3ULL
+
+static uint64_t _sched_class_hash(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= SCHED_CLASS_FNV_PRIME;
+	}
+	return hash;
+}
+
+#define SCHED_CLASS_HASH(hash, field) \
+	hash = _sched_class_hash(hash, &(field), sizeof(field))
+
+static uint64_t _sched_class_hash_str(uint64_t hash, const char *str)
+{
+	if (!str)
+		return _sched_class_hash(hash, "", 1);
+	return _sched_class_hash(hash, str, strlen(str) + 1);
+}
+
+extern uint64_t job_sched_class(job_record_t *job_ptr)
+{
+	struct job_details *details = job_ptr->details;
+	multi_core_data_t *mc_ptr;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	/*
+	 * Jobs whose placement depends on more than the fields hashed below
+	 * are never grouped.
+	 */
+	if (!details || job_ptr->het_job_id || job_ptr->resv_list ||
+	    job_ptr->fed_details || details->expanding_jobid ||
+	    (job_ptr->deadline && (job_ptr->deadline != NO_VAL)))
+		return 0;
+
+	SCHED_CLASS_HASH(hash, job_ptr->part_ptr);
+	SCHED_CLASS_HASH(hash, job_ptr->resv_ptr);
+	SCHED_CLASS_HASH(hash, job_ptr->assoc_id);
+	SCHED_CLASS_HASH(hash, job_ptr->qos_id);
+	SCHED_CLASS_HASH(hash, job_ptr->time_limit);
+	SCHED_CLASS_HASH(hash, job_ptr->time_min);
+	SCHED_CLASS_HASH(hash, job_ptr->bit_flags);
+	SCHED_CLASS_HASH(hash, job_ptr->delay_boot);
+	SCHED_CLASS_HASH(hash, job_ptr->power_flags);
+	SCHED_CLASS_HASH(hash, job_ptr->wait4switch);
+	SCHED_CLASS_HASH(hash, job_ptr->req_switch);
+
+	SCHED_CLASS_HASH(hash, details->min_nodes);
+	SCHED_CLASS_HASH(hash, details->max_nodes);
+	SCHED_CLASS_HASH(hash, details->min_cpus);
+	SCHED_CLASS_HASH(hash, details->max_cpus);
+	SCHED_CLASS_HASH(hash, details->pn_min_cpus);
+	SCHED_CLASS_HASH(hash, details->pn_min_memory);
+	SCHED_CLASS_HASH(hash, details->pn_min_tmp_disk);
+	SCHED_CLASS_HASH(hash, details->cpus_per_task);
+	SCHED_CLASS_HASH(hash, details->ntasks_per_node);
+	SCHED_CLASS_HASH(hash, details->ntasks_per_tres);
+	SCHED_CLASS_HASH(hash, details->num_tasks);
+	SCHED_CLASS_HASH(hash, details->task_dist);
+	SCHED_CLASS_HASH(hash, details->plane_size);
+	SCHED_CLASS_HASH(hash, details->contiguous);
+	SCHED_CLASS_HASH(hash, details->core_spec);
+	SCHED_CLASS_HASH(hash, details->overcommit);
+	SCHED_CLASS_HASH(hash, details->share_res);
+	SCHED_CLASS_HASH(hash, details->whole_node);
+	hash = _sched_class_hash_str(hash, details->features);
+	hash = _sched_class_hash_str(hash, details->req_nodes);
+	hash = _sched_class_hash_str(hash, details->exc_nodes);
+	if ((mc_ptr = details->mc_ptr)) {
+		SCHED_CLASS_HASH(hash, mc_ptr->boards_per_node);
+		SCHED_CLASS_HASH(hash, mc_ptr->sockets_per_board);
+		SCHED_CLASS_HASH(hash, mc_ptr->sockets_per_node);
+		SCHED_CLASS_HASH(hash, mc_ptr->cores_per_socket);
+		SCHED_CLASS_HASH(hash, mc_ptr->threads_per_core);
+		SCHED_CLASS_HASH(hash, mc_ptr->ntasks_per_board);
+		SCHED_CLASS_HASH(hash, mc_ptr->ntasks_per_socket);
+		SCHED_CLASS_HASH(hash, mc_ptr->ntasks_per_core);
+		SCHED_CLASS_HASH(hash, mc_ptr->plane_size);
+	}
+
+	hash = _sched_class_hash_str(hash, job_ptr->cpus_per_tres);
+	hash = _sched_class_hash_str(hash, job_ptr->mem_per_tres);
+	hash = _sched_class_hash_str(hash, job_ptr->tres_per_job);
+	hash = _sched_class_hash_str(hash, job_ptr->tres_per_node);
+	hash = _sched_class_hash_str(hash, job_ptr->tres_per_socket);
+	hash = _sched_class_hash_str(hash, job_ptr->tres_per_task);
+	hash = _sched_class_hash_str(hash, job_ptr->licenses);
+	hash = _sched_class_hash_str(hash, job_ptr->network);
+	hash = _sched_class_hash_str(hash, job_ptr->mcs_label);
+
+	/* 0 is reserved for "not classified" */
+	return hash ? hash : 1;
+}
+
+static void _sched_class_id(void *item, const char **key, uint32_t *key_len)
+{
+	sched_class_rec_t *class_rec = item;
+
+	*key = (const char *) &class_rec->class;
+	*key_len = sizeof(class_rec->class);
+}
+
+static void _sched_class_free(void *item)
+{
+	xfree(item);
+}
+
+extern xhash_t *sched_class_table_create(void)
+{
+	return xhash_init(_sched_class_id, _sched_class_free);
+}
+
+extern uint32_t sched_class_fail_cnt(xhash_t *table, uint64_t class)
+{
+	sched_class_rec_t *class_rec;
+
+	if (!table || !class)
+		return 0;
+	if (!(class_rec = xhash_get(table, (const char *) &class,
+				    sizeof(class))))
+		return 0;
+	return class_rec->fail_cnt;
+}
+
+extern void sched_class_add_fail(xhash_t *table, uint64_t class)
+{
+	sched_class_rec_t *class_rec;
+
+	if (!table || !class)
+		return;
+	if (!(class_rec = xhash_get(table, (const char *) &class,
+				    sizeof(class)))) {
+		class_rec = xmalloc(sizeof(*class_rec));
+		class_rec->class = class;
+		xhash_add(table, class_rec);
+	}
+	class_rec->fail_cnt++;
+}
+
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
  * in order of decreasing priority then submit time and the by increasing
  * job id */
@@ -2162,8 +2396,7 @@ static void _split_env(batch_job_launch_msg_t *launch_msg_ptr)
 }
 
 /* Given a scheduled job, return a pointer to it batch_job_launch_msg_t data */
-static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
-						     uint16_t protocol_version)
+static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr)
 {
 	char *fail_why = NULL;
 	batch_job_launch_msg_t *launch_msg_ptr;
@@ -2193,7 +2426,7 @@ static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 	launch_msg_ptr->restart_cnt   = job_ptr->restart_cnt;
 	launch_msg_ptr->profile       = job_ptr->profile;
 
-	if (make_batch_job_cred(launch_msg_ptr, job_ptr, protocol_version)) {
+	if (make_batch_job_cred(launch_msg_ptr, job_ptr)) {
 		/* FIXME: This is a kludge, but this event indicates a serious
 		 * problem with Munge or OpenSSH and should never happen. We
 		 * are too deep into the job launch to gracefully clean up from
@@ -2218,6 +2451,7 @@ static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 	launch_msg_ptr->std_out = xstrdup(job_ptr->details->std_out);
 	launch_msg_ptr->work_dir = xstrdup(job_ptr->details->work_dir);
 
+	load_job_details_argv(job_ptr->details);
 	launch_msg_ptr->argc = job_ptr->details->argc;
 	launch_msg_ptr->argv = xduparray(job_ptr->details->argc,
 					 job_ptr->details->argv);
@@ -2578,7 +2812,7 @@ extern void launch_job(job_record_t *job_ptr)
 
 	(void)build_batch_step(job_ptr);
 
-	launch_msg_ptr = _build_launch_job_msg(launch_job_ptr,protocol_version);
+	launch_msg_ptr = _build_launch_job_msg(launch_job_ptr);
 	if (launch_msg_ptr == NULL)
 		return;
 	if (launch_job_ptr->het_job_id)
@@ -2603,10 +2837,11 @@ extern void launch_job(job_record_t *job_ptr)
  *                         uid and nodes have already been set
  * IN job_ptr - pointer to job record
  * RET 0 or error code
+ * NOTE: The credential is not signed yet, the agent signs it before sending
+ *	 the launch request so that no slurmctld locks are held meanwhile.
  */
 extern int make_batch_job_cred(batch_job_launch_msg_t *launch_msg_ptr,
-			       job_record_t *job_ptr,
-			       uint16_t protocol_version)
+			       job_record_t *job_ptr)
 {
 	slurm_cred_arg_t cred_arg;
 	job_resources_t *job_resrcs_ptr;
@@ -2651,12 +2886,11 @@ extern int make_batch_job_cred(batch_job_launch_msg_t *launch_msg_ptr,
 	cred_arg.sockets_per_node    = job_resrcs_ptr->sockets_per_node;
 	cred_arg.sock_core_rep_count = job_resrcs_ptr->sock_core_rep_count;
 
-	launch_msg_ptr->cred = slurm_cred_create(slurmctld_config.cred_ctx,
-						 &cred_arg, protocol_version);
+	launch_msg_ptr->cred = slurm_cred_create_unsigned(&cred_arg);
 
 	if (launch_msg_ptr->cred)
 		return SLURM_SUCCESS;
-	error("slurm_cred_create failure for batch job %u",
+	error("slurm_cred_create_unsigned failure for batch job %u",
 	      cred_arg.step_id.job_id);
 	return SLURM_ERROR;
 }
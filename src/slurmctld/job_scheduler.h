@@ -42,6 +42,7 @@
 #ifndef _JOB_SCHEDULER_H
 #define _JOB_SCHEDULER_H
 
+#include "src/common/xhash.h"
 #include "src/slurmctld/slurmctld.h"
 
 typedef struct job_queue_rec {
@@ -56,6 +57,11 @@ typedef struct job_queue_rec {
 					 * in without requesting */
 } job_queue_rec_t;
 
+typedef struct {
+	job_queue_rec_t **recs;		/* binary heap, first to test at 0 */
+	int rec_cnt;
+} job_queue_heap_t;
+
 /* Use as return values for test_job_dependency. */
 enum {
 	NO_DEPEND = 0,
@@ -167,10 +173,10 @@ extern void launch_job(job_record_t *job_ptr);
  *                         uid and nodes have already been set
  * IN job_ptr - pointer to job record
  * RET 0 or error code
+ * NOTE: The credential is left unsigned, the agent signs it before sending
  */
 extern int make_batch_job_cred(batch_job_launch_msg_t *launch_msg_ptr,
-			       job_record_t *job_ptr,
-			       uint16_t protocol_version);
+			       job_record_t *job_ptr);
 
 /*
  * Determine which nodes must be rebooted for a job
@@ -244,6 +250,46 @@ extern void sort_job_queue(List job_queue);
  *	in order of decreasing priority */
 extern int sort_job_queue2(void *x, void *y);
 
+/*
+ * job_queue_heap_create - move the records of a job_queue made by
+ *	build_job_queue() into a binary heap, so that job_queue_heap_pop()
+ *	returns them in sort_job_queue() order without sorting the records
+ *	that a scheduling pass never reaches
+ * IN/OUT job_queue - emptied, to be freed by the caller
+ * RET heap to be freed with job_queue_heap_free()
+ */
+extern job_queue_heap_t *job_queue_heap_create(List job_queue);
+
+/*
+ * job_queue_heap_pop - remove the next record to test from the heap
+ * RET record to be xfreed by the caller, NULL if the heap is empty
+ */
+extern job_queue_rec_t *job_queue_heap_pop(job_queue_heap_t *heap);
+
+/* job_queue_heap_free - free a heap and any records left in it */
+extern void job_queue_heap_free(job_queue_heap_t *heap);
+
+/*
+ * job_sched_class - hash the fields of a pending job that decide whether it
+ *	can be placed (partition, reservation, association, QOS, time limit,
+ *	node/CPU/memory/TRES counts, constraints, ...). Jobs with the same
+ *	class either all fit in a given node state or none of them do.
+ * RET class value, 0 if the job must always be tested on its own
+ */
+extern uint64_t job_sched_class(job_record_t *job_ptr);
+
+/*
+ * Track job classes that failed to start during one scheduling pass.
+ * Free the table with xhash_free().
+ */
+extern xhash_t *sched_class_table_create(void);
+
+/* RET count of members of class that failed to start, 0 if none */
+extern uint32_t sched_class_fail_cnt(xhash_t *table, uint64_t class);
+
+/* Record that a member of class failed to start */
+extern void sched_class_add_fail(xhash_t *table, uint64_t class);
+
 /*
  * Determine if a job's dependencies are met
  * Inputs: job_ptr
@@ -108,6 +108,7 @@ bitstr_t *power_node_bitmap = NULL;	/* bitmap of powered down nodes */
 bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 bitstr_t *rs_node_bitmap    = NULL; 	/* bitmap of resuming nodes */
+node_sched_table_t node_sched_table;	/* per-node arrays for filtering */
 
 static void 	_dump_node_state(node_record_t *dump_node_ptr, buf_t *buffer);
 static front_end_record_t * _front_end_reg(
@@ -116,6 +117,7 @@ static bool	_is_cloud_hidden(node_record_t *node_ptr);
 static void 	_make_node_down(node_record_t *node_ptr,
 				time_t event_time);
 static bool	_node_is_hidden(node_record_t *node_ptr, uid_t uid);
+static void	_node_sched_table_free(void);
 static buf_t *_open_node_state_file(char **state_file);
 static void 	_pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
 			   uint16_t protocol_version, uint16_t show_flags);
@@ -309,6 +311,7 @@ extern int load_all_node_state ( bool state_only )
 	hostlist_t down_nodes = NULL;
 	bool power_save_mode = false;
 	uint16_t protocol_version = NO_VAL16;
+	DEF_TIMERS;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 
@@ -316,6 +319,7 @@ extern int load_all_node_state ( bool state_only )
 		power_save_mode = true;
 
 	/* read the file */
+	START_TIMER;
 	lock_state_files ();
 	buffer = _open_node_state_file(&state_file);
 	if (!buffer) {
@@ -658,7 +662,8 @@ extern int load_all_node_state ( bool state_only )
 		xfree(cpu_spec_list);
 	}
 
-fini:	info("Recovered state of %d nodes", node_cnt);
+fini:	END_TIMER;
+	info("Recovered state of %d nodes %s", node_cnt, TIME_STR);
 	if (hs) {
 		char node_names[128];
 		hostset_ranged_string(hs, sizeof(node_names), node_names);
@@ -2336,6 +2341,7 @@ static void _split_node_config(node_record_t *node_ptr,
 	}
 	config_ptr->cores = reg_msg->cores;
 	config_ptr->tot_sockets = reg_msg->sockets;
+	node_sched_table_sync(node_ptr);
 }
 
 /*
@@ -2777,6 +2783,7 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 		}
 		if (IS_NODE_IDLE(node_ptr)) {
 			node_ptr->owner = NO_VAL;
+			node_sched_table_sync(node_ptr);
 			xfree(node_ptr->mcs_label);
 		}
 
@@ -3141,6 +3148,7 @@ extern int validate_nodes_via_front_end(
 			}
 			if (IS_NODE_IDLE(node_ptr)) {
 				node_ptr->owner = NO_VAL;
+				node_sched_table_sync(node_ptr);
 				xfree(node_ptr->mcs_label);
 			}
 
@@ -3700,6 +3708,7 @@ extern void make_node_alloc(node_record_t *node_ptr, job_record_t *job_ptr)
 	     (job_ptr->part_ptr->flags & PART_FLAG_EXCLUSIVE_USER))) {
 		node_ptr->owner_job_cnt++;
 		node_ptr->owner = job_ptr->user_id;
+		node_sched_table_sync(node_ptr);
 	}
 
 	if (slurm_mcs_get_select(job_ptr) == 1) {
@@ -3811,6 +3820,7 @@ static void _make_node_down(node_record_t *node_ptr, time_t event_time)
 	node_flags &= (~NODE_STATE_COMPLETING);
 	node_ptr->node_state = NODE_STATE_DOWN | node_flags;
 	node_ptr->owner = NO_VAL;
+	node_sched_table_sync(node_ptr);
 	xfree(node_ptr->mcs_label);
 	bit_clear (avail_node_bitmap, inx);
 	bit_clear (cg_node_bitmap,    inx);
@@ -3912,6 +3922,7 @@ void make_node_idle(node_record_t *node_ptr, job_record_t *job_ptr)
 		bit_clear(cg_node_bitmap, inx);
 		if (IS_NODE_IDLE(node_ptr)) {
 			node_ptr->owner = NO_VAL;
+			node_sched_table_sync(node_ptr);
 			xfree(node_ptr->mcs_label);
 		}
 	}
@@ -3969,6 +3980,7 @@ fini:
 			      __func__);
 		} else if (--node_ptr->owner_job_cnt == 0) {
 			node_ptr->owner = NO_VAL;
+			node_sched_table_sync(node_ptr);
 			xfree(node_ptr->mcs_label);
 		}
 	}
@@ -4023,9 +4035,68 @@ extern void node_fini (void)
 	FREE_NULL_BITMAP(share_node_bitmap);
 	FREE_NULL_BITMAP(up_node_bitmap);
 	FREE_NULL_BITMAP(rs_node_bitmap);
+	_node_sched_table_free();
 	node_fini2();
 }
 
+static void _node_sched_table_free(void)
+{
+	xfree(node_sched_table.cpus);
+	xfree(node_sched_table.real_memory);
+	xfree(node_sched_table.tmp_disk);
+	xfree(node_sched_table.tot_sockets);
+	xfree(node_sched_table.cores);
+	xfree(node_sched_table.threads);
+	xfree(node_sched_table.owner);
+	node_sched_table.node_cnt = 0;
+}
+
+extern void node_sched_table_build(void)
+{
+	node_record_t *node_ptr;
+	int i;
+
+	if (node_sched_table.node_cnt != node_record_count) {
+		_node_sched_table_free();
+		node_sched_table.cpus = xcalloc(node_record_count,
+						sizeof(uint16_t));
+		node_sched_table.real_memory = xcalloc(node_record_count,
+						       sizeof(uint64_t));
+		node_sched_table.tmp_disk = xcalloc(node_record_count,
+						    sizeof(uint32_t));
+		node_sched_table.tot_sockets = xcalloc(node_record_count,
+						       sizeof(uint16_t));
+		node_sched_table.cores = xcalloc(node_record_count,
+						 sizeof(uint16_t));
+		node_sched_table.threads = xcalloc(node_record_count,
+						   sizeof(uint16_t));
+		node_sched_table.owner = xcalloc(node_record_count,
+						 sizeof(uint32_t));
+		node_sched_table.node_cnt = node_record_count;
+	}
+
+	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
+	     i++, node_ptr++)
+		node_sched_table_sync(node_ptr);
+}
+
+extern void node_sched_table_sync(node_record_t *node_ptr)
+{
+	config_record_t *config_ptr = node_ptr->config_ptr;
+	int inx = node_ptr - node_record_table_ptr;
+
+	if ((inx < 0) || (inx >= node_sched_table.node_cnt))
+		return;	/* table not built yet */
+
+	node_sched_table.cpus[inx] = config_ptr->cpus;
+	node_sched_table.real_memory[inx] = config_ptr->real_memory;
+	node_sched_table.tmp_disk[inx] = config_ptr->tmp_disk;
+	node_sched_table.tot_sockets[inx] = config_ptr->tot_sockets;
+	node_sched_table.cores[inx] = config_ptr->cores;
+	node_sched_table.threads[inx] = config_ptr->threads;
+	node_sched_table.owner[inx] = node_ptr->owner;
+}
+
 /* Reset a node's CPU load value */
 extern void reset_node_load(char *node_name, uint32_t cpu_load)
 {
@@ -453,6 +453,9 @@ static void _log_feature_nodes(job_feature_t  *job_feat_ptr)
  * For every element in the feature_list, identify the nodes with that feature
  * either active or available and set the feature_list's node_bitmap_active and
  * node_bitmap_avail fields accordingly.
+ * The bitmaps are kept with the job's feature_list and only rebuilt when
+ * node_features_gen or can_reboot changed since they were set, so testing a
+ * job again is just bitmap operations on its feature_list.
  */
 extern void find_feature_nodes(List feature_list, bool can_reboot)
 {
@@ -464,6 +467,9 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = list_next(feat_iter))) {
+		if ((job_feat_ptr->node_bitmap_gen == node_features_gen) &&
+		    (job_feat_ptr->node_bitmap_reboot == can_reboot))
+			continue;
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
 		node_feat_ptr = list_find_first(active_feature_list,
@@ -491,6 +497,8 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 			job_feat_ptr->node_bitmap_avail =
 				bit_copy(job_feat_ptr->node_bitmap_active);
 		}
+		job_feat_ptr->node_bitmap_gen = node_features_gen;
+		job_feat_ptr->node_bitmap_reboot = can_reboot;
 
 		_log_feature_nodes(job_feat_ptr);
 	}
@@ -769,7 +777,7 @@ extern void filter_by_node_owner(job_record_t *job_ptr,
 {
 	ListIterator job_iterator;
 	job_record_t *job_ptr2;
-	node_record_t *node_ptr;
+	uint32_t *owner = node_sched_table.owner;
 	int i;
 
 	if ((job_ptr->details->whole_node == WHOLE_NODE_USER) ||
@@ -790,10 +798,9 @@ extern void filter_by_node_owner(job_record_t *job_ptr,
 	}
 
 	/* Need to filter out any nodes exclusively allocated to other users */
-	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
-	     i++, node_ptr++) {
-		if ((node_ptr->owner != NO_VAL) &&
-		    (node_ptr->owner != job_ptr->user_id))
+	xassert(node_sched_table.node_cnt == node_record_count);
+	for (i = 0; i < node_sched_table.node_cnt; i++) {
+		if ((owner[i] != NO_VAL) && (owner[i] != job_ptr->user_id))
 			bit_clear(usable_node_mask, i);
 	}
 }
@@ -3132,8 +3139,10 @@ extern int job_req_node_filter(job_record_t *job_ptr,
 	int i;
 	struct job_details *detail_ptr = job_ptr->details;
 	multi_core_data_t *mc_ptr;
-	node_record_t *node_ptr;
-	config_record_t *config_ptr;
+	node_sched_table_t *tbl = &node_sched_table;
+	uint32_t min_cpus, min_tmp_disk;
+	uint64_t min_mem;
+	uint16_t min_sockets = 0, min_cores = 0, min_threads = 0;
 	bool has_xor = false;
 
 	if (detail_ptr == NULL) {
@@ -3142,34 +3151,34 @@ extern int job_req_node_filter(job_record_t *job_ptr,
 		return EINVAL;
 	}
 
-	mc_ptr = detail_ptr->mc_ptr;
-	for (i = 0; i < node_record_count; i++) {
-		if (!bit_test(avail_bitmap, i))
-			continue;
-		node_ptr = node_record_table_ptr + i;
-		config_ptr = node_ptr->config_ptr;
-		if ((detail_ptr->pn_min_cpus  > config_ptr->cpus)   ||
-		    ((detail_ptr->pn_min_memory & (~MEM_PER_CPU)) >
-		     config_ptr->real_memory) 			    ||
-		    ((detail_ptr->pn_min_memory & (MEM_PER_CPU)) &&
-		     ((detail_ptr->pn_min_memory & (~MEM_PER_CPU)) *
-		      detail_ptr->pn_min_cpus) >
-		     config_ptr->real_memory) 			    ||
-		    (detail_ptr->pn_min_tmp_disk >
-		     config_ptr->tmp_disk)) {
-			bit_clear(avail_bitmap, i);
-			continue;
-		}
-		if (mc_ptr &&
-		    (((mc_ptr->sockets_per_node > config_ptr->tot_sockets) &&
-		      (mc_ptr->sockets_per_node != NO_VAL16)) ||
-		     ((mc_ptr->cores_per_socket > config_ptr->cores)   &&
-		      (mc_ptr->cores_per_socket != NO_VAL16)) ||
-		     ((mc_ptr->threads_per_core > config_ptr->threads) &&
-		      (mc_ptr->threads_per_core != NO_VAL16)))) {
+	min_cpus = detail_ptr->pn_min_cpus;
+	min_tmp_disk = detail_ptr->pn_min_tmp_disk;
+	min_mem = detail_ptr->pn_min_memory & (~MEM_PER_CPU);
+	if ((detail_ptr->pn_min_memory & MEM_PER_CPU) && (min_cpus > 1))
+		min_mem *= min_cpus;
+	if ((mc_ptr = detail_ptr->mc_ptr)) {
+		if (mc_ptr->sockets_per_node != NO_VAL16)
+			min_sockets = mc_ptr->sockets_per_node;
+		if (mc_ptr->cores_per_socket != NO_VAL16)
+			min_cores = mc_ptr->cores_per_socket;
+		if (mc_ptr->threads_per_core != NO_VAL16)
+			min_threads = mc_ptr->threads_per_core;
+	}
+
+	/*
+	 * Test every node, not just those set in avail_bitmap, so the loop
+	 * only reads the node_sched_table arrays and clearing an already
+	 * clear bit is harmless.
+	 */
+	xassert(tbl->node_cnt == node_record_count);
+	for (i = 0; i < tbl->node_cnt; i++) {
+		if ((tbl->cpus[i] < min_cpus) ||
+		    (tbl->real_memory[i] < min_mem) ||
+		    (tbl->tmp_disk[i] < min_tmp_disk) ||
+		    (tbl->tot_sockets[i] < min_sockets) ||
+		    (tbl->cores[i] < min_cores) ||
+		    (tbl->threads[i] < min_threads))
 			bit_clear(avail_bitmap, i);
-			continue;
-		}
 	}
 
 	return valid_feature_counts(job_ptr, false, avail_bitmap, &has_xor);
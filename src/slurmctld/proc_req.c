@@ -117,6 +117,41 @@ static uint64_t rpc_user_time[RPC_USER_SIZE] = { 0 };
 static config_response_msg_t *config_for_slurmd = NULL;
 static config_response_msg_t *config_for_clients = NULL;
 
+/*
+ * Already packed REQUEST_JOB_INFO and REQUEST_NODE_INFO replies, shared by
+ * all clients asking with the same show_flags and protocol version until the
+ * underlying job or node state changes. Without SHOW_ALL root also sees jobs
+ * outside of any partition, so its job replies are kept apart. Readers hold a reference while
+ * sending, so no slurmctld lock is needed to serve a cached reply.
+ */
+#define INFO_CACHE_SIZE		8
+#define INFO_CACHE_MAX_AGE	2	/* seconds */
+typedef struct {
+	char *data;
+	int data_size;
+	int ref_cnt;
+	bool retired;
+	time_t build_time;
+	time_t conf_update;
+	time_t part_update;
+	time_t state_update;
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	bool root_view;
+} packed_info_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	packed_info_t *info[INFO_CACHE_SIZE];
+} packed_info_cache_t;
+
+static packed_info_cache_t job_info_cache = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+static packed_info_cache_t node_info_cache = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t  reconfig_cond = PTHREAD_COND_INITIALIZER;
@@ -1472,6 +1507,185 @@ static void _slurm_rpc_dump_conf(slurm_msg_t * msg)
 	}
 }
 
+/* Caller must hold the cache mutex */
+static bool _packed_info_valid(packed_info_t *info, time_t state_update,
+			       time_t now)
+{
+	/*
+	 * Records changed in the same second the reply was built can not be
+	 * told apart by their update time, so such replies are never valid.
+	 */
+	return (!info->retired &&
+		(info->state_update == state_update) &&
+		(info->build_time > info->state_update) &&
+		(info->part_update == last_part_update) &&
+		(info->conf_update == slurm_conf.last_update) &&
+		((now - info->build_time) < INFO_CACHE_MAX_AGE));
+}
+
+/* Caller must hold the cache mutex */
+static void _packed_info_free(packed_info_t *info)
+{
+	xfree(info->data);
+	xfree(info);
+}
+
+/*
+ * Find a still valid packed reply, with a reference held on it.
+ * Release the reference with _packed_info_release().
+ * RET reply or NULL if not cached
+ */
+static packed_info_t *_packed_info_get(packed_info_cache_t *cache,
+				       uint16_t show_flags, bool root_view,
+				       uint16_t protocol_version,
+				       time_t state_update)
+{
+	packed_info_t *info = NULL;
+	time_t now = time(NULL);
+	int i;
+
+	slurm_mutex_lock(&cache->mutex);
+	for (i = 0; i < INFO_CACHE_SIZE; i++) {
+		if (!cache->info[i] ||
+		    (cache->info[i]->show_flags != show_flags) ||
+		    (cache->info[i]->root_view != root_view) ||
+		    (cache->info[i]->protocol_version != protocol_version))
+			continue;
+		if (_packed_info_valid(cache->info[i], state_update, now)) {
+			info = cache->info[i];
+			info->ref_cnt++;
+		}
+		break;
+	}
+	slurm_mutex_unlock(&cache->mutex);
+
+	return info;
+}
+
+static void _packed_info_release(packed_info_cache_t *cache,
+				 packed_info_t *info)
+{
+	slurm_mutex_lock(&cache->mutex);
+	if ((--info->ref_cnt == 0) && info->retired)
+		_packed_info_free(info);
+	slurm_mutex_unlock(&cache->mutex);
+}
+
+/*
+ * Publish a freshly packed reply, replacing any previous reply with the same
+ * show_flags, view and protocol version or else the oldest one.
+ * Caller must hold the locks the reply was packed under, ownership of data is
+ * transferred to the cache.
+ * RET published reply, with a reference held for the caller
+ */
+static packed_info_t *_packed_info_put(packed_info_cache_t *cache,
+				       char *data, int data_size,
+				       uint16_t show_flags, bool root_view,
+				       uint16_t protocol_version,
+				       time_t state_update)
+{
+	packed_info_t *info;
+	int i, slot = 0;
+
+	info = xmalloc(sizeof(*info));
+	info->data = data;
+	info->data_size = data_size;
+	info->build_time = time(NULL);
+	info->conf_update = slurm_conf.last_update;
+	info->part_update = last_part_update;
+	info->state_update = state_update;
+	info->protocol_version = protocol_version;
+	info->show_flags = show_flags;
+	info->root_view = root_view;
+	info->ref_cnt = 1;
+
+	slurm_mutex_lock(&cache->mutex);
+	for (i = 0; i < INFO_CACHE_SIZE; i++) {
+		if (!cache->info[i]) {
+			slot = i;
+			continue;
+		}
+		if ((cache->info[i]->show_flags == show_flags) &&
+		    (cache->info[i]->root_view == root_view) &&
+		    (cache->info[i]->protocol_version == protocol_version)) {
+			slot = i;
+			break;
+		}
+		if (cache->info[slot] &&
+		    (cache->info[i]->build_time <
+		     cache->info[slot]->build_time))
+			slot = i;
+	}
+	if (cache->info[slot]) {
+		cache->info[slot]->retired = true;
+		if (cache->info[slot]->ref_cnt == 0)
+			_packed_info_free(cache->info[slot]);
+	}
+	cache->info[slot] = info;
+	slurm_mutex_unlock(&cache->mutex);
+
+	return info;
+}
+
+/* Send a packed reply, caller keeps ownership of the data */
+static void _send_packed_info(slurm_msg_t *msg, uint16_t msg_type,
+			      char *data, int data_size)
+{
+	slurm_msg_t response_msg;
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = msg_type;
+	response_msg.data = data;
+	response_msg.data_size = data_size;
+
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+}
+
+/*
+ * Replies only depend on show_flags and protocol version, and not on the
+ * requesting user, if no partition is hidden from anybody. Job replies still
+ * differ for root, see root_view.
+ */
+static bool _all_parts_public(void)
+{
+	ListIterator part_iterator;
+	part_record_t *part_ptr;
+	bool rc = true;
+
+	xassert(verify_lock(PART_LOCK, READ_LOCK));
+
+	part_iterator = list_iterator_create(part_list);
+	while ((part_ptr = list_next(part_iterator))) {
+		if ((part_ptr->flags & PART_FLAG_HIDDEN) ||
+		    part_ptr->allow_groups) {
+			rc = false;
+			break;
+		}
+	}
+	list_iterator_destroy(part_iterator);
+
+	return rc;
+}
+
+extern void packed_info_cache_fini(void)
+{
+	packed_info_cache_t *caches[] = { &job_info_cache, &node_info_cache };
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(caches); i++) {
+		slurm_mutex_lock(&caches[i]->mutex);
+		for (j = 0; j < INFO_CACHE_SIZE; j++) {
+			if (!caches[i]->info[j])
+				continue;
+			caches[i]->info[j]->retired = true;
+			if (caches[i]->info[j]->ref_cnt == 0)
+				_packed_info_free(caches[i]->info[j]);
+			caches[i]->info[j] = NULL;
+		}
+		slurm_mutex_unlock(&caches[i]->mutex);
+	}
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 {
@@ -1484,8 +1698,35 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	/* Locks: Read config job part */
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
+	packed_info_t *cached = NULL;
+	bool cacheable;
+	uint16_t show_flags = job_info_request_msg->show_flags;
+	/* Jobs without a partition are only packed for root */
+	bool root_view = (!(show_flags & SHOW_ALL) && (msg->auth_uid == 0));
+	time_t changed_since = 0;
 
 	START_TIMER;
+	cacheable = (!job_info_request_msg->job_ids &&
+		     !(show_flags & SHOW_DELTA) &&
+		     !(slurm_conf.private_data & PRIVATE_DATA_JOBS));
+	if (cacheable &&
+	    (cached = _packed_info_get(&job_info_cache,
+				       job_info_request_msg->show_flags,
+				       root_view, msg->protocol_version,
+				       last_job_update))) {
+		if ((job_info_request_msg->last_update - 1) >=
+		    cached->state_update) {
+			debug3("_slurm_rpc_dump_jobs, no change");
+			slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		} else {
+			_send_packed_info(msg, RESPONSE_JOB_INFO, cached->data,
+					  cached->data_size);
+		}
+		_packed_info_release(&job_info_cache, cached);
+		END_TIMER2("_slurm_rpc_dump_jobs");
+		return;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
 
@@ -1495,6 +1736,21 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 		debug3("_slurm_rpc_dump_jobs, no change");
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
 	} else {
+		if (cacheable &&
+		    !(show_flags & SHOW_ALL) &&
+		    !_all_parts_public())
+			cacheable = false;
+		/*
+		 * Deltas are only valid if the set of jobs visible to the
+		 * user can not have changed other than by job updates.
+		 */
+		if ((show_flags & SHOW_DELTA) &&
+		    (job_info_request_msg->job_ids ||
+		     (slurm_conf.private_data & PRIVATE_DATA_JOBS) ||
+		     (!(show_flags & SHOW_ALL) && !_all_parts_public())))
+			show_flags &= ~SHOW_DELTA;
+		if (job_info_request_msg->last_update > last_part_update)
+			changed_since = job_info_request_msg->last_update;
 		if (job_info_request_msg->job_ids) {
 			pack_spec_jobs(&dump, &dump_size,
 				       job_info_request_msg->job_ids,
@@ -1502,11 +1758,17 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 				       msg->auth_uid, NO_VAL,
 				       msg->protocol_version);
 		} else {
-			pack_all_jobs(&dump, &dump_size,
-				      job_info_request_msg->show_flags,
-				      msg->auth_uid, NO_VAL,
+			pack_all_jobs(&dump, &dump_size, show_flags,
+				      msg->auth_uid, NO_VAL, changed_since,
 				      msg->protocol_version);
 		}
+		if (cacheable) {
+			cached = _packed_info_put(
+				&job_info_cache, dump, dump_size,
+				job_info_request_msg->show_flags, root_view,
+				msg->protocol_version, last_job_update);
+			dump = NULL;
+		}
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(job_read_lock);
 		END_TIMER2("_slurm_rpc_dump_jobs");
@@ -1514,6 +1776,13 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 		info("_slurm_rpc_dump_jobs, size=%d %s", dump_size, TIME_STR);
 #endif
 
+		if (cached) {
+			_send_packed_info(msg, RESPONSE_JOB_INFO, cached->data,
+					  cached->data_size);
+			_packed_info_release(&job_info_cache, cached);
+			return;
+		}
+
 		response_init(&response_msg, msg);
 		response_msg.msg_type = RESPONSE_JOB_INFO;
 		response_msg.data = dump;
@@ -1542,7 +1811,7 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
 	pack_all_jobs(&dump, &dump_size, job_info_request_msg->show_flags,
-		      msg->auth_uid, job_info_request_msg->user_id,
+		      msg->auth_uid, job_info_request_msg->user_id, 0,
 		      msg->protocol_version);
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		unlock_slurmctld(job_read_lock);
@@ -1749,6 +2018,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	 * select plugins), read part (for part_is_visible) */
 	slurmctld_lock_t node_write_lock = {
 		READ_LOCK, NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK };
+	packed_info_t *cached = NULL;
 
 	START_TIMER;
 	if ((slurm_conf.private_data & PRIVATE_DATA_NODES) &&
@@ -1759,6 +2029,22 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		return;
 	}
 
+	if ((cached = _packed_info_get(&node_info_cache,
+				       node_req_msg->show_flags, false,
+				       msg->protocol_version,
+				       last_node_update))) {
+		if ((node_req_msg->last_update - 1) >= cached->state_update) {
+			debug3("_slurm_rpc_dump_nodes, no change");
+			slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		} else {
+			_send_packed_info(msg, RESPONSE_NODE_INFO,
+					  cached->data, cached->data_size);
+		}
+		_packed_info_release(&node_info_cache, cached);
+		END_TIMER2("_slurm_rpc_dump_nodes");
+		return;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(node_write_lock);
 
@@ -1772,6 +2058,14 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	} else {
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
 			      msg->auth_uid, msg->protocol_version);
+		if ((node_req_msg->show_flags & SHOW_ALL) ||
+		    _all_parts_public()) {
+			cached = _packed_info_put(
+				&node_info_cache, dump, dump_size,
+				node_req_msg->show_flags, false,
+				msg->protocol_version, last_node_update);
+			dump = NULL;
+		}
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
@@ -1779,6 +2073,13 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		info("_slurm_rpc_dump_nodes, size=%d %s", dump_size, TIME_STR);
 #endif
 
+		if (cached) {
+			_send_packed_info(msg, RESPONSE_NODE_INFO,
+					  cached->data, cached->data_size);
+			_packed_info_release(&node_info_cache, cached);
+			return;
+		}
+
 		response_init(&response_msg, msg);
 		response_msg.msg_type = RESPONSE_NODE_INFO;
 		response_msg.data = dump;
@@ -5339,6 +5640,8 @@ static void _clear_rpc_stats(void)
 	memset(rpc_user_id, 0, sizeof(rpc_user_id));
 	memset(rpc_user_time, 0, sizeof(rpc_user_time));
 	slurm_mutex_unlock(&rpc_mutex);
+
+	agent_reset_stats();
 }
 
 static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
@@ -5370,7 +5673,7 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 		pack32_array(rpc_user_cnt,  i, buffer);
 		pack64_array(rpc_user_time, i, buffer);
 
-		agent_pack_pending_rpc_stats(buffer);
+		agent_pack_pending_rpc_stats(buffer, protocol_version);
 
 	}
 
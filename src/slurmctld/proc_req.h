@@ -96,6 +96,12 @@ extern void response_init(slurm_msg_t *resp, slurm_msg_t *msg);
 extern int slurm_drain_nodes(char *node_list, char *reason,
 			     uint32_t reason_uid);
 
+/*
+ * Free the packed job and node information replies cached for
+ * REQUEST_JOB_INFO and REQUEST_NODE_INFO.
+ */
+extern void packed_info_cache_fini(void);
+
 /* Copy an array of type char **, xmalloc() the array and xstrdup() the
  * strings in the array */
 extern char **xduparray(uint32_t size, char ** array);
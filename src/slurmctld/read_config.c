@@ -98,6 +98,7 @@
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
 bool node_features_updated = true;
+uint64_t node_features_gen = 1;	/* bumped when feature lists change */
 bool slurmctld_init_db = true;
 
 static void _acct_restore_active_jobs(void);
@@ -1388,6 +1389,7 @@ int read_slurm_conf(int recover, bool reconfig)
 
 	_validate_het_jobs();
 	(void) _sync_nodes_to_comp_job();/* must follow select_g_node_init() */
+	node_sched_table_build();	/* must follow _sync_nodes_to_*() */
 	load_part_uid_allow_list(1);
 
 	/* NOTE: Run load_all_resv_state() before _restore_job_accounting */
@@ -1616,6 +1618,7 @@ extern void build_feature_list_eq(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	config_iterator = list_iterator_create(config_list);
 	while ((config_ptr = list_next(config_iterator))) {
@@ -1685,6 +1688,7 @@ extern void build_feature_list_ne(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
 	     i++, node_ptr++) {
@@ -1749,6 +1753,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 		xfree(tmp_str);
 	}
 	node_features_updated = true;
+	node_features_gen++;
 }
 
 static void _gres_reconfig(bool reconfig)
@@ -66,6 +66,7 @@
 #include "src/common/parse_time.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_time.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
@@ -4180,6 +4181,7 @@ extern int load_all_resv_state(int recover)
 	buf_t *buffer;
 	slurmctld_resv_t *resv_ptr = NULL;
 	uint16_t protocol_version = NO_VAL16;
+	DEF_TIMERS;
 
 	last_resv_update = time(NULL);
 	if ((recover == 0) && resv_list) {
@@ -4188,6 +4190,7 @@ extern int load_all_resv_state(int recover)
 	}
 
 	/* Read state file and validate */
+	START_TIMER;
 	_create_resv_lists(true);
 
 	/* read the file */
@@ -4228,11 +4231,13 @@ extern int load_all_resv_state(int recover)
 			break;
 
 		_add_resv_to_lists(resv_ptr);
-		info("Recovered state of reservation %s", resv_ptr->name);
+		debug("Recovered state of reservation %s", resv_ptr->name);
 	}
 
 	_validate_all_reservations();
-	info("Recovered state of %d reservations", list_count(resv_list));
+	END_TIMER;
+	info("Recovered state of %d reservations %s", list_count(resv_list),
+	     TIME_STR);
 	free_buf(buffer);
 	return error_code;
 
@@ -4241,7 +4246,9 @@ unpack_error:
 		fatal("Incomplete reservation data checkpoint file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
 	error("Incomplete reservation data checkpoint file");
 	_validate_all_reservations();
-	info("Recovered state of %d reservations", list_count(resv_list));
+	END_TIMER;
+	info("Recovered state of %d reservations %s", list_count(resv_list),
+	     TIME_STR);
 	free_buf(buffer);
 	return EFAULT;
 }
@@ -79,6 +79,12 @@
 #define MAX_SERVER_THREADS 256
 #endif
 
+/* Maximum connections accepted but not yet serviced, as a multiple of
+ * MAX_SERVER_THREADS. Further connections wait in the listen backlog. */
+#ifndef MAX_PENDING_CONN_FACTOR
+#define MAX_PENDING_CONN_FACTOR 4
+#endif
+
 /* Maximum number of threads to service emails (see MailProg) */
 #ifndef MAX_MAIL_THREADS
 #define MAX_MAIL_THREADS 64
@@ -165,6 +171,8 @@ typedef struct diag_stats {
 	uint32_t schedule_cycle_counter;
 	uint32_t schedule_cycle_depth;
 	uint32_t schedule_queue_len;
+	uint32_t select_cache_hits;
+	uint32_t select_cache_misses;
 
 	uint32_t jobs_submitted;
 	uint32_t jobs_started;
@@ -190,10 +198,17 @@ typedef struct diag_stats {
 	uint32_t bf_last_depth_try;
 	uint32_t bf_queue_len;
 	uint32_t bf_queue_len_sum;
+	uint32_t bf_slice_copied;
+	uint32_t bf_slice_reused;
 	uint32_t bf_table_size;
 	uint32_t bf_table_size_sum;
 	time_t   bf_when_last_cycle;
 
+	uint32_t decay_cycle_counter;
+	uint32_t decay_cycle_last;
+	uint32_t decay_cycle_max;
+	uint64_t decay_cycle_sum;
+
 	uint32_t latency;
 } diag_stats_t;
 
@@ -231,6 +246,7 @@ extern uint32_t   cluster_cpus;
 extern bool disable_remote_singleton;
 extern int max_depend_depth;
 extern bool node_features_updated;
+extern uint64_t node_features_gen;	/* changes with the feature lists */
 extern pthread_cond_t purge_thread_cond;
 extern pthread_mutex_t purge_thread_lock;
 extern pthread_mutex_t check_bf_running_lock;
@@ -287,6 +303,27 @@ extern bitstr_t *share_node_bitmap;	/* bitmap of sharable nodes */
 extern bitstr_t *up_node_bitmap;	/* bitmap of up nodes, not DOWN */
 extern bitstr_t *rs_node_bitmap;	/* next_state=resume nodes */
 
+/*
+ * Copies of the node fields scanned once per node by the scheduler's node
+ * filters, stored one array per field and indexed like node_record_table_ptr.
+ * Filtering thousands of nodes then reads a few dense arrays rather than
+ * pulling a full node_record_t and its config_record_t into cache per node.
+ * Node state, partition membership and features are already kept as the
+ * bitmaps above and in the partition and feature records.
+ */
+typedef struct {
+	int node_cnt;			/* node_record_count when built */
+	uint16_t *cpus;			/* config_ptr->cpus */
+	uint64_t *real_memory;		/* config_ptr->real_memory */
+	uint32_t *tmp_disk;		/* config_ptr->tmp_disk */
+	uint16_t *tot_sockets;		/* config_ptr->tot_sockets */
+	uint16_t *cores;		/* config_ptr->cores */
+	uint16_t *threads;		/* config_ptr->threads */
+	uint32_t *owner;		/* node_ptr->owner */
+} node_sched_table_t;
+
+extern node_sched_table_t node_sched_table;
+
 /*****************************************************************************\
  *  FRONT_END parameters and data structures
 \*****************************************************************************/
@@ -503,6 +540,9 @@ typedef struct job_feature {
 	uint8_t op_code;		/* separator, see FEATURE_OP_ above */
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
+	uint64_t node_bitmap_gen;	/* node_features_gen when the node
+					 * bitmaps were set, 0 if never */
+	bool node_bitmap_reboot;	/* can_reboot when bitmaps were set */
 	uint16_t paren;			/* count of enclosing parenthesis */
 } job_feature_t;
 
@@ -523,6 +563,10 @@ struct job_details {
 					 * priority, */
 	uint32_t argc;			/* count of argv elements */
 	char **argv;			/* arguments for a batch job script */
+	uint32_t argv_len;		/* if set, argv is still packed in the
+					 * mapped job_state file, see
+					 * load_job_details_argv() */
+	uint32_t argv_offset;		/* of packed argv in job_state file */
 	time_t begin_time;		/* start at this time (srun --begin),
 					 * resets to time first eligible
 					 * (all dependencies satisfied) */
@@ -739,13 +783,19 @@ struct job_record {
 	uint32_t het_job_offset;	/* HetJob component index */
 	List het_job_list;		/* List of job pointers to all
 					 * components */
+	uint64_t info_hash;		/* hash of job info last packed with
+					 * SHOW_DELTA */
+	time_t info_change_time;	/* time info_hash last changed */
+	uint64_t state_hash;		/* hash of state last saved, only used
+					 * by dump_all_job_state() */
 	uint32_t job_id;		/* job ID */
-	job_record_t *job_next;		/* next entry with same hash index */
 	job_record_t *job_array_next_j;	/* job array linked list by job_id */
 	job_record_t *job_array_next_t;	/* job array linked list by task_id */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint32_t job_state;		/* state of the job */
+	job_record_t *job_user_next;	/* next job of the same user */
+	job_record_t *job_user_prev;	/* previous job of the same user */
 	uint16_t kill_on_node_fail;	/* 1 if job should be killed on
 					 * node failure */
 	time_t last_sched_eval;		/* last time job was evaluated for scheduling */
@@ -1259,6 +1309,17 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id);
  */
 extern job_record_t *find_job_record(uint32_t job_id);
 
+/*
+ * foreach_user_job - call f() for every job record of the given user, using
+ *	the job user index rather than walking job_list
+ * IN uid - user whose jobs are wanted
+ * IN f - function to call, f() may not create or purge job records
+ * IN arg - argument passed to f()
+ * RET number of jobs processed, negative if f() stopped the walk as with
+ *	list_for_each()
+ */
+extern int foreach_user_job(uid_t uid, ListForF f, void *arg);
+
 /*
  * find_first_node_record - find a record for first node in the bitmap
  * IN node_bitmap
@@ -1833,6 +1894,13 @@ extern int load_all_job_state ( void );
  */
 extern int load_all_node_state ( bool state_only );
 
+/*
+ * load_job_details_argv - unpack a job's argv if it was left packed in the
+ *	mapped job_state file at startup. Call before using argc or argv.
+ * IN detail_ptr - job details, may be NULL
+ */
+extern void load_job_details_argv(struct job_details *detail_ptr);
+
 /*
  * load_last_job_id - load only the last job ID from state save file.
  * RET 0 or error code
@@ -1905,6 +1973,18 @@ void push_reconfig_to_slurmd(void);
 /* node_fini - free all memory associated with node records */
 extern void node_fini (void);
 
+/*
+ * node_sched_table_build - (re)build node_sched_table from
+ *	node_record_table_ptr, call after the node table is rebuilt
+ */
+extern void node_sched_table_build(void);
+
+/*
+ * node_sched_table_sync - copy one node's fields into node_sched_table, call
+ *	after changing its config_ptr or owner
+ */
+extern void node_sched_table_sync(node_record_t *node_ptr);
+
 /* node_did_resp - record that the specified node is responding
  * IN name - name of the node */
 extern void node_did_resp (char *name);
@@ -1934,15 +2014,19 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN changed_since - with SHOW_DELTA in show_flags, only pack jobs changed
+ *	and list jobs purged since this time
  * IN protocol_version - slurm protocol version of client
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
  *	whenever the data format changes
+ * NOTE: SHOW_DELTA must only be set if visibility of jobs does not depend
+ *	on uid, all packed jobs will be reported as such otherwise
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			  uint16_t protocol_version);
+			  time_t changed_since, uint16_t protocol_version);
 
 /*
  * pack_spec_jobs - dump job information for specified jobs in
@@ -40,6 +40,7 @@
 
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/common/forward.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
 #include "src/common/xstring.h"
@@ -140,6 +141,26 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_het_jobs,
 			       buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				pack32(slurmctld_diag_stats.bf_slice_copied,
+				       buffer);
+				pack32(slurmctld_diag_stats.bf_slice_reused,
+				       buffer);
+				pack32(slurmctld_diag_stats.select_cache_hits,
+				       buffer);
+				pack32(slurmctld_diag_stats.select_cache_misses,
+				       buffer);
+				pack32(slurmctld_diag_stats.decay_cycle_counter,
+				       buffer);
+				pack32(slurmctld_diag_stats.decay_cycle_last,
+				       buffer);
+				pack32(slurmctld_diag_stats.decay_cycle_max,
+				       buffer);
+				pack64(slurmctld_diag_stats.decay_cycle_sum,
+				       buffer);
+				forward_pack_stats(buffer);
+			}
 		}
 	}
 
@@ -157,6 +178,12 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.schedule_cycle_sum = 0;
 	slurmctld_diag_stats.schedule_cycle_counter = 0;
 	slurmctld_diag_stats.schedule_cycle_depth = 0;
+	slurmctld_diag_stats.select_cache_hits = 0;
+	slurmctld_diag_stats.select_cache_misses = 0;
+	slurmctld_diag_stats.decay_cycle_counter = 0;
+	slurmctld_diag_stats.decay_cycle_last = 0;
+	slurmctld_diag_stats.decay_cycle_max = 0;
+	slurmctld_diag_stats.decay_cycle_sum = 0;
 	slurmctld_diag_stats.jobs_submitted = 0;
 	slurmctld_diag_stats.jobs_started = 0;
 	slurmctld_diag_stats.jobs_completed = 0;
@@ -177,9 +204,12 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_queue_len = 0;
 	slurmctld_diag_stats.bf_queue_len_sum = 0;
 	slurmctld_diag_stats.bf_table_size_sum = 0;
+	slurmctld_diag_stats.bf_slice_copied = 0;
+	slurmctld_diag_stats.bf_slice_reused = 0;
 	slurmctld_diag_stats.bf_cycle_max = 0;
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
+	forward_reset_stats();
 
 	last_proc_req_start = time(NULL);
 }
@@ -4129,7 +4129,7 @@ extern int load_step_state(job_record_t *job_ptr, buf_t *buffer,
 		step_ptr->jobacct = jobacct;
 	}
 
-	info("Recovered %pS", step_ptr);
+	debug("Recovered %pS", step_ptr);
 	return SLURM_SUCCESS;
 
 unpack_error:
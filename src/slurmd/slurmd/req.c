@@ -158,6 +158,7 @@ static void _rpc_timelimit(slurm_msg_t *);
 static void _rpc_reattach_tasks(slurm_msg_t *);
 static void _rpc_suspend_job(slurm_msg_t *msg);
 static void _rpc_terminate_job(slurm_msg_t *);
+static void _rpc_terminate_jobs(slurm_msg_t *);
 static void _rpc_shutdown(slurm_msg_t *msg);
 static void _rpc_reconfig(slurm_msg_t *msg);
 static void _rpc_reconfig_with_config(slurm_msg_t *msg);
@@ -314,6 +315,10 @@ slurmd_req(slurm_msg_t *msg)
 		last_slurmctld_msg = time(NULL);
 		_rpc_terminate_job(msg);
 		break;
+	case REQUEST_TERMINATE_JOBS:
+		last_slurmctld_msg = time(NULL);
+		_rpc_terminate_jobs(msg);
+		break;
 	case REQUEST_SHUTDOWN:
 		_rpc_shutdown(msg);
 		break;
@@ -3778,9 +3783,11 @@ _rpc_timelimit(slurm_msg_t *msg)
 	/*
 	 *  Indicate to slurmctld that we've received the message
 	 */
-	slurm_send_rc_msg(msg, SLURM_SUCCESS);
-	close(msg->conn_fd);
-	msg->conn_fd = -1;
+	if (msg->conn_fd >= 0) {
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		close(msg->conn_fd);
+		msg->conn_fd = -1;
+	}
 
 	if (req->step_id.step_id != NO_VAL) {
 		slurm_conf_t *cf;
@@ -5055,6 +5062,67 @@ _rpc_abort_job(slurm_msg_t *msg)
 	_launch_complete_rm(req->step_id.job_id);
 }
 
+static void *_terminate_one_job(void *arg)
+{
+	slurm_msg_t *msg = arg;
+
+	if (msg->msg_type == REQUEST_TERMINATE_JOB)
+		_rpc_terminate_job(msg);
+	else
+		_rpc_timelimit(msg);
+
+	slurm_free_msg(msg);
+	return NULL;
+}
+
+/*
+ * Several kill requests of one type coalesced by slurmctld into one RPC.
+ * Acknowledge the whole batch once, then handle each job in its own thread
+ * exactly as if it had arrived alone on a connection that was already
+ * replied to (conn_fd = -1), so epilog completion is still sent per job.
+ */
+static void _rpc_terminate_jobs(slurm_msg_t *msg)
+{
+	terminate_jobs_msg_t *req = msg->data;
+	slurm_msg_t *job_msg;
+	int i;
+
+	if (!_slurm_authorized_user(msg->auth_uid)) {
+		error("Security violation: terminate_jobs req from uid %u",
+		      msg->auth_uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	if ((req->msg_type != REQUEST_TERMINATE_JOB) &&
+	    (req->msg_type != REQUEST_KILL_TIMELIMIT) &&
+	    (req->msg_type != REQUEST_KILL_PREEMPTED)) {
+		error("%s: invalid message type %s", __func__,
+		      rpc_num2string(req->msg_type));
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+
+	debug("%s: %u %s requests", __func__, req->job_cnt,
+	      rpc_num2string(req->msg_type));
+	slurm_send_rc_msg(msg, SLURM_SUCCESS);
+
+	for (i = 0; i < req->job_cnt; i++) {
+		job_msg = xmalloc(sizeof(slurm_msg_t));
+
+		slurm_msg_t_init(job_msg);
+		job_msg->msg_type = req->msg_type;
+		job_msg->protocol_version = msg->protocol_version;
+		job_msg->auth_uid = msg->auth_uid;
+		job_msg->auth_uid_set = msg->auth_uid_set;
+		job_msg->address = msg->address;
+		job_msg->data = req->kill_msgs[i];
+		req->kill_msgs[i] = NULL;
+		slurm_thread_create_detached(NULL, _terminate_one_job, job_msg);
+	}
+	req->job_cnt = 0;
+}
+
 static void
 _rpc_terminate_job(slurm_msg_t *msg)
 {
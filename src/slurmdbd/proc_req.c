@@ -72,6 +72,10 @@ static void _process_job_start(slurmdbd_conn_t *slurmdbd_conn,
 			       dbd_job_start_msg_t *job_start_msg,
 			       dbd_id_rc_msg_t *id_rc_msg);
 
+static pthread_mutex_t query_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  query_cond = PTHREAD_COND_INITIALIZER;
+static int             query_running = 0;
+
 #ifndef NDEBUG
 /*
  * Used alongside the testsuite to signal that the RPC should be processed
@@ -912,6 +916,23 @@ static int _get_events(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
+/* Send one chunk of a streamed DBD_GET_JOBS_COND reply */
+static int _send_jobs_part(List job_list, void *arg)
+{
+	slurmdbd_conn_t *slurmdbd_conn = arg;
+	dbd_list_msg_t list_msg = { .my_list = job_list };
+	buf_t *buffer = init_buf(1024);
+	int rc;
+
+	pack16((uint16_t) DBD_GOT_JOBS_PART, buffer);
+	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
+			       DBD_GOT_JOBS_PART, buffer);
+	rc = slurm_persist_send_msg(slurmdbd_conn->conn, buffer);
+	free_buf(buffer);
+
+	return rc;
+}
+
 static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			  buf_t **out_buffer, uint32_t *uid)
 {
@@ -956,8 +977,20 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 		}
 	}
 
-	list_msg.my_list = jobacct_storage_g_get_jobs_cond(
-		slurmdbd_conn->db_conn, *uid, job_cond);
+	/*
+	 * Streamed jobs go out as DBD_GOT_JOBS_PART messages while they are
+	 * read, the (empty) DBD_GOT_JOBS below ends the reply.
+	 */
+	if (job_cond->flags & JOBCOND_FLAG_STREAM) {
+		errno = jobacct_storage_g_get_jobs_cond_cb(
+			slurmdbd_conn->db_conn, *uid, job_cond,
+			_send_jobs_part, slurmdbd_conn);
+		/* Give the client a real error to print */
+		if (errno == SLURM_ERROR)
+			errno = ESLURM_DB_CONNECTION;
+	} else
+		list_msg.my_list = jobacct_storage_g_get_jobs_cond(
+			slurmdbd_conn->db_conn, *uid, job_cond);
 
 	if (!errno) {
 		if (!list_msg.my_list)
@@ -2864,6 +2897,11 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	}
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
+	/*
+	 * Store the whole batch in one transaction, proc_req() commits once
+	 * when this returns instead of after every message.
+	 */
+	slurmdbd_conn->mult_msg = true;
 	/* START_TIMER; */
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
@@ -2887,6 +2925,7 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			break;
 	}
 	list_iterator_destroy(itr);
+	slurmdbd_conn->mult_msg = false;
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
@@ -3123,6 +3162,91 @@ static int _shutdown(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
+/* Read-only RPCs which can keep the database busy for a long time */
+static bool _is_query_rpc(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case DBD_GET_ASSOCS:
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_EVENTS:
+	case DBD_GET_JOBS_COND:
+	case DBD_GET_PROBS:
+	case DBD_GET_RESVS:
+	case DBD_GET_TXN:
+	case DBD_GET_WCKEY_USAGE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Wait for one of the MaxQueryThreads query slots. Each connection has its
+ * own thread and database connection, so a slurmctld's records are already
+ * stored in order and apart from any sacct. What a flood of queries can do
+ * is load the database and take all the connection threads. This bounds both
+ * for user queries. Registered slurmctld connections never wait here.
+ * OUT got_slot - set if the caller must call _query_slot_put()
+ * RET SLURM_SUCCESS or EAGAIN if no slot was free within MessageTimeout
+ */
+static int _query_slot_get(slurmdbd_conn_t *slurmdbd_conn, uint16_t msg_type,
+			   bool *got_slot)
+{
+	struct timespec ts = {0, 0};
+	int rc = SLURM_SUCCESS;
+
+	*got_slot = false;
+	if (!slurmdbd_conf->max_query_threads ||
+	    slurmdbd_conn->conn->rem_port || !_is_query_rpc(msg_type))
+		return SLURM_SUCCESS;
+
+	ts.tv_sec = time(NULL) + slurm_conf.msg_timeout;
+	slurm_mutex_lock(&query_mutex);
+	while (!shutdown_time &&
+	       (query_running >= slurmdbd_conf->max_query_threads) &&
+	       (time(NULL) < ts.tv_sec))
+		slurm_cond_timedwait(&query_cond, &query_mutex, &ts);
+	if (!shutdown_time &&
+	    (query_running < slurmdbd_conf->max_query_threads)) {
+		query_running++;
+		*got_slot = true;
+	} else
+		rc = EAGAIN;
+	slurm_mutex_unlock(&query_mutex);
+
+	return rc;
+}
+
+static void _query_slot_put(void)
+{
+	slurm_mutex_lock(&query_mutex);
+	if (query_running > 0)
+		query_running--;
+	else
+		error("%s: query_running underflow", __func__);
+	slurm_cond_signal(&query_cond);
+	slurm_mutex_unlock(&query_mutex);
+}
+
+/*
+ * The slurmctld's transaction could not be committed, so nothing it just
+ * sent was stored. Replace the response with an error so it is sent again.
+ */
+static int _commit_failed(slurmdbd_conn_t *slurmdbd_conn, uint16_t msg_type,
+			  buf_t **out_buffer)
+{
+	char *comment = "Unable to commit to the database, try again later";
+
+	error("CONN:%u %s (%s)", slurmdbd_conn->conn->fd, comment,
+	      slurmdbd_msg_type_2_str(msg_type, 1));
+	FREE_NULL_BUFFER(*out_buffer);
+	*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+						ESLURM_DB_CONNECTION, comment,
+						msg_type);
+	return ESLURM_DB_CONNECTION;
+}
+
 /* Process an incoming RPC
  * slurmdbd_conn IN/OUT - in will that the conn.fd set before
  *       calling and db_conn and conn.version will be filled in with the init.
@@ -3139,10 +3263,22 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 	int rc = SLURM_SUCCESS;
 	char *comment = NULL;
 	slurmdb_rpc_obj_t *rpc_obj;
+	bool query_slot = false;
 
 	DEF_TIMERS;
 	START_TIMER;
 
+	if (_query_slot_get(slurmdbd_conn, msg->msg_type, &query_slot)) {
+		comment = "Too many queries running, try again later";
+		info("CONN:%u %s (%s)", slurmdbd_conn->conn->fd, comment,
+		     slurmdbd_msg_type_2_str(msg->msg_type, 1));
+		rc = EAGAIN;
+		*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+							rc, comment,
+							msg->msg_type);
+		goto end_it;
+	}
+
 	switch (msg->msg_type) {
 	case REQUEST_PERSIST_INIT:
 		rc = _unpack_persist_init(slurmdbd_conn, msg, out_buffer, uid);
@@ -3361,20 +3497,28 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 		break;
 	}
 
+	if (query_slot)
+		_query_slot_put();
+
 	if (rc == ESLURM_ACCESS_DENIED)
 		error("CONN:%u Security violation, %s",
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->mult_msg) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
 		   (don't ever use autocommit with innodb)
 		*/
-		acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+		if (acct_storage_g_commit(slurmdbd_conn->db_conn, 1) &&
+		    (rc == SLURM_SUCCESS))
+			rc = _commit_failed(slurmdbd_conn, msg->msg_type,
+					    out_buffer);
 	}
 
+end_it:
 	END_TIMER;
 
 	slurm_mutex_lock(&rpc_mutex);
@@ -46,6 +46,7 @@
 typedef struct {
 	slurm_persist_conn_t *conn;
 	void *db_conn; /* database connection */
+	bool mult_msg; /* in DBD_SEND_MULT_MSG, commit once at the end */
 	char *tres_str;
 } slurmdbd_conn_t;
 
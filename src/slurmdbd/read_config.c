@@ -39,6 +39,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <pwd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -330,12 +331,31 @@ extern int read_slurmdbd_conf(void)
 		else if (slurm_conf.msg_timeout > 100)
 			info("WARNING: MessageTimeout is too high for effective fault-tolerance");
 
+		slurmdbd_conf->max_query_threads =
+			DEFAULT_SLURMDBD_MAX_QUERY_THREADS;
 		s_p_get_string(&slurmdbd_conf->parameters, "Parameters", tbl);
 		if (slurmdbd_conf->parameters) {
+			char *tmp_ptr;
+
 			if (xstrcasestr(slurmdbd_conf->parameters,
 					"PreserveCaseUser"))
 				slurmdbd_conf->persist_conn_rc_flags |=
 					PERSIST_FLAG_P_USER_CASE;
+			/*                  0123456789012345 */
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "MaxQueryThreads="))) {
+				char *end_ptr = NULL;
+				long val;
+
+				errno = 0;
+				val = strtol(tmp_ptr + 16, &end_ptr, 10);
+				if (errno || (end_ptr == tmp_ptr + 16) ||
+				    ((*end_ptr != '\0') && (*end_ptr != ',')) ||
+				    (val < 0) || (val > UINT16_MAX))
+					fatal("Bad value \"%s\" for MaxQueryThreads",
+					      tmp_ptr + 16);
+				slurmdbd_conf->max_query_threads = val;
+			}
 		}
 
 		s_p_get_string(&slurmdbd_conf->pid_file, "PidFile", tbl);
@@ -188,6 +188,16 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 	if (params.format && strstr(params.format, "C"))
 		show_flags |= SHOW_DETAIL;
 
+	/*
+	 * When iterating only fetch changed jobs. Not possible if printing
+	 * modifies the job records kept between iterations: unless --array is
+	 * used, pending array tasks are combined into the master record's
+	 * array_bitmap, array_task_str and state_desc.
+	 */
+	if (params.iterate && params.array_flag && !params.priority_flag &&
+	    !params.job_list)
+		show_flags |= SHOW_DELTA;
+
 	if (old_job_ptr) {
 		if (clear_old)
 			old_job_ptr->last_update = 0;
@@ -206,7 +216,10 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 				old_job_ptr->last_update,
 				&new_job_ptr, show_flags);
 		}
-		if (error_code ==  SLURM_SUCCESS)
+		if ((error_code == SLURM_SUCCESS) && new_job_ptr->delta) {
+			slurm_merge_job_info_msg(old_job_ptr, new_job_ptr);
+			new_job_ptr = old_job_ptr;
+		} else if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
 		else if (slurm_get_errno () == SLURM_NO_CHANGE_IN_DATA) {
 			error_code = SLURM_SUCCESS;
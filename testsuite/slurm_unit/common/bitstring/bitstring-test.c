@@ -132,6 +132,88 @@ main(int argc, char *argv[])
 		TEST(bit_fls(bs1) == -1, "pick");
 		bit_free(bs1);
 	}
+	note("Testing word kernels against bit_test");
+	{
+		int sizes[] = { 1, 63, 64, 65, 255, 256, 257, 1000, 4099 };
+		int i, bit, ok;
+
+		srand(42);
+		for (i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+			int nbits = sizes[i];
+			int cnt1 = 0, cnt2 = 0, cnt_and = 0, cnt_rng = 0;
+			int ffs1 = -1, ffs2 = -1;
+			int start = nbits / 3, end = nbits - nbits / 5;
+			bitstr_t *bs1 = bit_alloc(nbits);
+			bitstr_t *bs2 = bit_alloc(nbits);
+			bitstr_t *bs3;
+
+			for (bit = 0; bit < nbits; bit++) {
+				if (rand() & 1)
+					bit_set(bs1, bit);
+				if (rand() & 1)
+					bit_set(bs2, bit);
+			}
+			/* leave set bits past the end of the last word */
+			bit_not(bs1);
+
+			for (bit = 0; bit < nbits; bit++) {
+				if (bit_test(bs1, bit) && !cnt1++)
+					ffs1 = bit;
+				if (bit_test(bs2, bit) && !cnt2++)
+					ffs2 = bit;
+				if (bit_test(bs1, bit) && bit_test(bs2, bit))
+					cnt_and++;
+				if (bit_test(bs1, bit) &&
+				    (bit >= start) && (bit < end))
+					cnt_rng++;
+			}
+			TEST(bit_set_count(bs1) == cnt1, "set_count");
+			TEST(bit_set_count(bs2) == cnt2, "set_count");
+			TEST(bit_clear_count(bs1) == (nbits - cnt1),
+			     "clear_count");
+			TEST(bit_set_count_range(bs1, start, end) == cnt_rng,
+			     "set_count_range");
+			TEST(bit_overlap(bs1, bs2) == cnt_and, "overlap");
+			TEST(bit_overlap_any(bs1, bs2) == (cnt_and > 0),
+			     "overlap_any");
+			TEST(bit_ffs(bs1) == ffs1, "ffs");
+			TEST(bit_ffs(bs2) == ffs2, "ffs");
+
+			bs3 = bit_copy(bs1);
+			bit_and(bs3, bs2);
+			TEST(bit_set_count(bs3) == cnt_and, "and");
+			TEST(bit_super_set(bs3, bs1), "super_set");
+			TEST(bit_super_set(bs3, bs2), "super_set");
+			bit_and_not(bs3, bs2);
+			TEST(bit_set_count(bs3) == 0, "and_not");
+			TEST(!bit_overlap_any(bs3, bs2), "overlap_any");
+			bit_or_not(bs3, bs2);
+			bit_not(bs3);
+			TEST(bit_equal(bs3, bs2), "or_not");
+
+			/* only set bits past the end of the last word */
+			bit_clear_all(bs2);
+			bit_not(bs2);
+			bit_nclear(bs2, 0, nbits - 1);
+			TEST(bit_ffs(bs2) == -1, "ffs tail");
+
+			/* a single shared bit in the last partial word */
+			bit_clear_all(bs1);
+			bit_clear_all(bs2);
+			bit_set(bs1, nbits - 1);
+			TEST(bit_ffs(bs1) == (nbits - 1), "ffs tail");
+			bit_set(bs2, nbits - 1);
+			TEST(bit_overlap_any(bs1, bs2), "overlap_any tail");
+			TEST(bit_overlap(bs1, bs2) == 1, "overlap tail");
+			bit_clear(bs2, nbits - 1);
+			ok = !bit_overlap_any(bs1, bs2);
+			TEST(ok, "overlap_any tail");
+
+			bit_free(bs1);
+			bit_free(bs2);
+			bit_free(bs3);
+		}
+	}
 	note("Testing realloc");
 	{
 		bitstr_t *bs = bit_alloc(1);